@@ -0,0 +1,121 @@
+/*
+ * batchOptimizer.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Air-time optimizer for a batch of pending commands. The batch is split in
+ *  segments at every entry the client marked "ordered", only entries inside one
+ *  segment are touched:
+ *   - a later command for the same unit supersedes an earlier one
+ *   - a later group command supersedes earlier commands for its address
+ *   - off commands for all 16 units of an address become one group frame
+ *  The remaining frames keep the order of the request, every frame takes the
+ *  same air time wherever it is sent.
+ */
+#include "batchOptimizer.h"
+
+#define BATCH_UNITS_PER_ADDRESS	16
+
+static int batch_same_receiver(const RFcommand * a, const RFcommand * b)
+{
+	return a->address == b->address && a->protocol == b->protocol;
+}
+
+/*
+ * @brief drop every entry that a later entry in the segment makes redundant
+ */
+static void batch_supersede(batchEntry * batch, int start, int end)
+{
+	int i, j;
+
+	for(i = start; i < end; i++){
+		for(j = i + 1; j < end && !batch[i].dropped; j++){
+			if(batch[j].dropped || !batch_same_receiver(&batch[i].command, &batch[j].command))
+				continue;
+			if(batch[j].command.group ||
+					(!batch[i].command.group && batch[i].command.unit == batch[j].command.unit)){
+				batch[i].dropped = 1;
+			}
+		}
+	}
+}
+
+/*
+ * @brief replace off commands covering every unit of an address by one group frame
+ */
+static void batch_substitute_groups(batchEntry * batch, int start, int end)
+{
+	int i, j;
+
+	for(i = start; i < end; i++){
+		uint16_t units = 0;
+		int repetitions = 0;
+
+		if(batch[i].dropped || batch[i].command.group || batch[i].command.value % 16 != 0)
+			continue;
+
+		for(j = i; j < end; j++){
+			if(batch[j].dropped || batch[j].command.group || batch[j].command.value % 16 != 0 ||
+					!batch_same_receiver(&batch[i].command, &batch[j].command))
+				continue;
+			units |= 1 << (batch[j].command.unit % BATCH_UNITS_PER_ADDRESS);
+			if(batch[j].command.repetitions > repetitions)
+				repetitions = batch[j].command.repetitions;
+		}
+		if(units != 0xFFFF)
+			continue;
+
+		for(j = i + 1; j < end; j++){
+			if(!batch[j].dropped && !batch[j].command.group && batch[j].command.value % 16 == 0 &&
+					batch_same_receiver(&batch[i].command, &batch[j].command))
+				batch[j].dropped = 1;
+		}
+		batch[i].command.group = 1;
+		batch[i].command.unit = 0;
+		batch[i].command.repetitions = repetitions;
+	}
+}
+
+/*
+ * @brief total air time of the entries that are still part of the plan
+ */
+uint32_t batchOptimizer_airtime_us(const batchEntry * batch, int count)
+{
+	uint32_t airtime = 0;
+	int i;
+
+	for(i = 0; i < count; i++){
+		if(!batch[i].dropped)
+			airtime += frameDispatcher_airtime_us(&batch[i].command);
+	}
+	return airtime;
+}
+
+/*
+ * @brief rewrite the batch into its transmission plan, returns the number of entries kept
+ */
+int batchOptimizer_plan(batchEntry * batch, int count)
+{
+	int start = 0;
+	int end;
+	int kept = 0;
+	int i;
+
+	while(start < count){
+		if(batch[start].ordered){
+			start++;
+			continue;
+		}
+		for(end = start; end < count && !batch[end].ordered; end++);
+
+		batch_supersede(batch, start, end);
+		batch_substitute_groups(batch, start, end);
+		start = end;
+	}
+
+	for(i = 0; i < count; i++){
+		if(!batch[i].dropped)
+			kept++;
+	}
+	return kept;
+}
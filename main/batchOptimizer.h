@@ -0,0 +1,27 @@
+/*
+ * batchOptimizer.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_BATCHOPTIMIZER_H_
+#define MAIN_BATCHOPTIMIZER_H_
+
+#include "frameDispatcher.h"
+#include "fadeEngine.h"
+
+typedef struct {
+		RFcommand command;
+		int ordered;		//marked by the client: keeps its position, never merged or dropped
+		int dropped;		//'1' when the plan does not transmit this entry
+		uint32_t delay_ms;	//scheduled instead of queued when delay or interval is set
+		uint32_t interval_ms;
+		int policy;			//state cache suppression policy
+		uint32_t fresh_ms;	//window in which the cached state is trusted
+		fadeRequest fade;	//fade parameters, a slot is reserved once the whole request is valid
+}batchEntry;
+
+int batchOptimizer_plan(batchEntry * batch, int count);
+uint32_t batchOptimizer_airtime_us(const batchEntry * batch, int count);
+
+#endif /* MAIN_BATCHOPTIMIZER_H_ */
@@ -70,7 +70,8 @@ static int cJSON_strcasecmp(const unsigned char *s1, const unsigned char *s2)
     {
         return 1;
     }
-    for(; tolower(*s1) == tolower(*s2); (void)++s1, ++s2)
+    /* names usually match byte for byte, only fold the case where they differ */
+    for(; (*s1 == *s2) || (tolower(*s1) == tolower(*s2)); (void)++s1, ++s2)
     {
         if (*s1 == '\0')
         {
@@ -89,6 +90,8 @@ typedef struct internal_hooks
 } internal_hooks;
 
 static internal_hooks global_hooks = { malloc, free, realloc };
+/* nodes use global_hooks while these are NULL */
+static internal_hooks node_hooks = { NULL, NULL, NULL };
 
 static unsigned char* cJSON_strdup(const unsigned char* str, const internal_hooks * const hooks)
 {
@@ -141,10 +144,23 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
+CJSON_PUBLIC(void) cJSON_InitNodeHooks(cJSON_Hooks* hooks)
+{
+    node_hooks.allocate = NULL;
+    node_hooks.deallocate = NULL;
+
+    /* a node has to go back where it came from, so both or neither */
+    if ((hooks != NULL) && (hooks->malloc_fn != NULL) && (hooks->free_fn != NULL))
+    {
+        node_hooks.allocate = hooks->malloc_fn;
+        node_hooks.deallocate = hooks->free_fn;
+    }
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    cJSON* node = (cJSON*)((node_hooks.allocate != NULL) ? node_hooks.allocate : hooks->allocate)(sizeof(cJSON));
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
@@ -153,6 +169,138 @@ static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
     return node;
 }
 
+#ifdef CJSON_OBJECT_INDEX
+/* The index of an object is an open addressing table of its members. Names are hashed case-insensitively
+ * so both cJSON_GetObjectItem and cJSON_GetObjectItemCaseSensitive can use it. Members are inserted in list
+ * order and probed linearly, so of duplicate names the first in the list is found first, as with the scan.
+ * The index of an array holds its elements in order. */
+typedef struct
+{
+    unsigned long hash;
+    cJSON *item;
+} index_slot;
+
+struct cJSON_Index
+{
+    size_t count; /* members of the object or array */
+    size_t mask; /* table size - 1, objects only */
+    index_slot slots[1];
+};
+
+/* FNV-1a of the lowercased name */
+static unsigned long index_hash(const unsigned char *name)
+{
+    unsigned long hash = 2166136261UL;
+    for (; *name != '\0'; name++)
+    {
+        hash ^= (unsigned long)tolower(*name);
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return hash;
+}
+
+static void index_drop(cJSON * const object)
+{
+    if (object->index != NULL)
+    {
+        global_hooks.deallocate(object->index);
+        object->index = NULL;
+    }
+}
+
+/* the index is a cache, building it does not change the object as seen from outside */
+static void index_build(cJSON * const object)
+{
+    struct cJSON_Index *index = NULL;
+    cJSON *member = NULL;
+    size_t count = 0;
+    size_t size = 1;
+    size_t position = 0;
+    cJSON_bool is_object = ((object->type & 0xFF) == cJSON_Object);
+
+    /* a reference shares its members with an item whose changes it would not see */
+    if ((!is_object && ((object->type & 0xFF) != cJSON_Array)) || (object->type & cJSON_IsReference))
+    {
+        return;
+    }
+
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        count++;
+    }
+    if (is_object)
+    {
+        /* keep the table at most half full */
+        while (size < (count * 2))
+        {
+            size *= 2;
+        }
+    }
+    else if (count > 0)
+    {
+        size = count;
+    }
+
+    index = (struct cJSON_Index*)global_hooks.allocate(sizeof(struct cJSON_Index) + ((size - 1) * sizeof(index_slot)));
+    if (index == NULL)
+    {
+        /* lookups keep walking the list */
+        return;
+    }
+    memset(index->slots, '\0', size * sizeof(index_slot));
+    index->count = count;
+    index->mask = size - 1;
+
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        unsigned long hash = 0;
+        if (!is_object)
+        {
+            index->slots[position++].item = member;
+            continue;
+        }
+        if (member->string == NULL)
+        {
+            continue;
+        }
+        hash = index_hash((const unsigned char*)member->string);
+        position = (size_t)hash & index->mask;
+        while (index->slots[position].item != NULL)
+        {
+            position = (position + 1) & index->mask;
+        }
+        index->slots[position].hash = hash;
+        index->slots[position].item = member;
+    }
+
+    object->index = index;
+}
+
+static cJSON *index_lookup(const struct cJSON_Index * const index, const char * const name, const cJSON_bool case_sensitive)
+{
+    unsigned long hash = index_hash((const unsigned char*)name);
+    size_t position = (size_t)hash & index->mask;
+    cJSON *member = NULL;
+
+    while ((member = index->slots[position].item) != NULL)
+    {
+        if (index->slots[position].hash == hash)
+        {
+            if (case_sensitive ? (strcmp(name, member->string) == 0) : (cJSON_strcasecmp((const unsigned char*)name, (const unsigned char*)member->string) == 0))
+            {
+                return member;
+            }
+        }
+        position = (position + 1) & index->mask;
+    }
+
+    return NULL;
+}
+#else
+#define index_drop(object)
+#endif
+
 /* Delete a cJSON structure. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *c)
 {
@@ -160,6 +308,10 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *c)
     while (c)
     {
         next = c->next;
+        if (!(c->type & cJSON_IsReference))
+        {
+            index_drop(c);
+        }
         if (!(c->type & cJSON_IsReference) && c->child)
         {
             cJSON_Delete(c->child);
@@ -172,26 +324,213 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *c)
         {
             global_hooks.deallocate(c->string);
         }
-        global_hooks.deallocate(c);
+        ((node_hooks.deallocate != NULL) ? node_hooks.deallocate : global_hooks.deallocate)(c);
         c = next;
     }
 }
 
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    cJSON_bool in_situ; /* strings are unescaped inside content, which is then writable */
+    const char * const *keep; /* members of the top level object to parse, taken by the first parse_object */
+    size_t depth; /* how deeply nested (in arrays/objects) the input at the current offset is */
+} parse_buffer;
+
+/* check if the given size is left to read in a given parse buffer (starting with 1) */
+#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
+/* check if the buffer can be accessed at the given index (starting with 0) */
+#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
+#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
+/* get a pointer to the buffer at the position */
+#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+
+/* Plain integers that fit an int are converted here, strtod is soft float on targets without a double FPU.
+ * Returns false, without consuming anything, for a number that needs the general path. */
+static cJSON_bool parse_integer(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *number = buffer_at_offset(input_buffer);
+    cJSON_bool negative = false;
+    size_t digits = 0;
+    size_t i = 0;
+    int value = 0;
+
+    if (can_access_at_index(input_buffer, 0) && (number[0] == '-'))
+    {
+        negative = true;
+        i++;
+    }
+    for (; can_access_at_index(input_buffer, i) && (number[i] >= '0') && (number[i] <= '9'); i++)
+    {
+        if (++digits > 9)
+        {
+            return false; /* might not fit */
+        }
+        value = (value * 10) + (number[i] - '0');
+    }
+    if ((digits == 0) || (can_access_at_index(input_buffer, i) && ((number[i] == '.') || (number[i] == 'e') || (number[i] == 'E'))))
+    {
+        return false;
+    }
+
+    item->valueint = negative ? -value : value;
+    item->valuedouble = item->valueint;
+    item->type = cJSON_Number;
+
+    input_buffer->offset += i;
+    return true;
+}
+
+#ifdef CJSON_INT_ONLY
+/* Integer-only build: the digits that fit an int are kept with a decimal scale, the fraction
+ * and exponent move the scale and the result is truncated towards zero and saturated. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *number = NULL;
+    cJSON_bool negative = false;
+    cJSON_bool exponent_negative = false;
+    cJSON_bool overflow = false;
+    size_t digits = 0;
+    size_t i = 0;
+    int value = 0;
+    int scale = 0;
+    int exponent = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false;
+    }
+    if (parse_integer(item, input_buffer))
+    {
+        return true;
+    }
+
+    number = buffer_at_offset(input_buffer);
+    if (can_access_at_index(input_buffer, i) && (number[i] == '-'))
+    {
+        negative = true;
+        i++;
+    }
+    for (; can_access_at_index(input_buffer, i) && (number[i] >= '0') && (number[i] <= '9'); i++, digits++)
+    {
+        if (value <= ((INT_MAX - (number[i] - '0')) / 10))
+        {
+            value = (value * 10) + (number[i] - '0');
+        }
+        else
+        {
+            /* the integral part is past INT_MAX, only a negative exponent can bring it back */
+            overflow = true;
+            scale++;
+        }
+    }
+    if (digits == 0)
+    {
+        return false; /* parse_error */
+    }
+    if (can_access_at_index(input_buffer, i) && (number[i] == '.'))
+    {
+        for (i++; can_access_at_index(input_buffer, i) && (number[i] >= '0') && (number[i] <= '9'); i++)
+        {
+            if (value <= ((INT_MAX - (number[i] - '0')) / 10))
+            {
+                value = (value * 10) + (number[i] - '0');
+                scale--;
+            }
+        }
+    }
+    if (can_access_at_index(input_buffer, i) && ((number[i] == 'e') || (number[i] == 'E')))
+    {
+        i++;
+        if (can_access_at_index(input_buffer, i) && ((number[i] == '+') || (number[i] == '-')))
+        {
+            exponent_negative = number[i] == '-';
+            i++;
+        }
+        for (; can_access_at_index(input_buffer, i) && (number[i] >= '0') && (number[i] <= '9'); i++)
+        {
+            if (exponent < 100)
+            {
+                exponent = (exponent * 10) + (number[i] - '0');
+            }
+        }
+        scale += exponent_negative ? -exponent : exponent;
+    }
+
+    if (overflow && (scale > 0))
+    {
+        value = INT_MAX;
+    }
+    for (; (scale > 0) && (value != 0); scale--)
+    {
+        value = (value > (INT_MAX / 10)) ? INT_MAX : (value * 10);
+    }
+    for (; (scale < 0) && (value != 0); scale++)
+    {
+        value /= 10;
+    }
+
+    item->valueint = negative ? -value : value;
+    item->valuedouble = item->valueint;
+    item->type = cJSON_Number;
+
+    input_buffer->offset += i;
+    return true;
+}
+#else
 /* Parse the input text to generate a number, and populate the result into item. */
-static const unsigned char *parse_number(cJSON * const item, const unsigned char * const input)
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
     double number = 0;
     unsigned char *after_end = NULL;
+    unsigned char number_c_string[64];
+    size_t i = 0;
 
-    if (input == NULL)
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
     {
-        return NULL;
+        return false;
+    }
+    if (parse_integer(item, input_buffer))
+    {
+        return true;
+    }
+
+    /* copy the number into a temporary buffer, strtod would read past the end of the input */
+    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+    {
+        switch (buffer_at_offset(input_buffer)[i])
+        {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '+':
+            case '-':
+            case 'e':
+            case 'E':
+            case '.':
+                number_c_string[i] = buffer_at_offset(input_buffer)[i];
+                break;
+
+            default:
+                goto loop_end;
+        }
     }
+loop_end:
+    number_c_string[i] = '\0';
 
-    number = strtod((const char*)input, (char**)&after_end);
-    if (input == after_end)
+    number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
     {
-        return NULL; /* parse_error */
+        return false; /* parse_error */
     }
 
     item->valuedouble = number;
@@ -212,10 +551,20 @@ static const unsigned char *parse_number(cJSON * const item, const unsigned char
 
     item->type = cJSON_Number;
 
-    return after_end;
+    input_buffer->offset += (size_t)(after_end - number_c_string);
+    return true;
 }
+#endif
 
 /* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+#ifdef CJSON_INT_ONLY
+CJSON_PUBLIC(cJSON_number) cJSON_SetNumberHelper(cJSON *object, cJSON_number number)
+{
+    object->valueint = number;
+
+    return object->valuedouble = number;
+}
+#else
 CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
 {
     if (number >= INT_MAX)
@@ -233,6 +582,7 @@ CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
 
     return object->valuedouble = number;
 }
+#endif
 
 typedef struct
 {
@@ -326,6 +676,7 @@ static void update_offset(printbuffer * const buffer)
     buffer->offset += strlen((const char*)buffer_pointer);
 }
 
+#ifndef CJSON_INT_ONLY
 /* Removes trailing zeroes from the end of a printed number */
 static cJSON_bool trim_trailing_zeroes(printbuffer * const buffer)
 {
@@ -411,6 +762,36 @@ static cJSON_bool print_number(const cJSON * const item, printbuffer * const out
 
     return true;
 }
+#else
+/* Render the number from the given item into a string, there is no fraction in the integer-only build. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer, const internal_hooks * const hooks)
+{
+    unsigned char *output_pointer = NULL;
+    int length = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    output_pointer = ensure(output_buffer, 21, hooks);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    length = sprintf((char*)output_pointer, "%d", item->valueint);
+
+    /* sprintf failed */
+    if (length < 0)
+    {
+        return false;
+    }
+
+    output_buffer->offset += (size_t)length;
+
+    return true;
+}
+#endif
 
 /* parse 4 digit hexadecimal number */
 static unsigned parse_hex4(const unsigned char * const input)
@@ -450,7 +831,7 @@ static unsigned parse_hex4(const unsigned char * const input)
 
 /* converts a UTF-16 literal to UTF-8
  * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer, const unsigned char **error_pointer)
+static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
 {
     long unsigned int codepoint = 0;
     unsigned int first_code = 0;
@@ -463,7 +844,6 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
     if ((input_end - first_sequence) < 6)
     {
         /* input ends unexpectedly */
-        *error_pointer = first_sequence;
         goto fail;
     }
 
@@ -473,7 +853,6 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
     /* check that the code is valid */
     if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)) || (first_code == 0))
     {
-        *error_pointer = first_sequence;
         goto fail;
     }
 
@@ -487,14 +866,12 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
         if ((input_end - second_sequence) < 6)
         {
             /* input ends unexpectedly */
-            *error_pointer = first_sequence;
             goto fail;
         }
 
         if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
         {
             /* missing second half of the surrogate pair */
-            *error_pointer = first_sequence;
             goto fail;
         }
 
@@ -504,7 +881,6 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
         if ((second_code < 0xDC00) || (second_code > 0xDFFF))
         {
             /* invalid second half of the surrogate pair */
-            *error_pointer = first_sequence;
             goto fail;
         }
 
@@ -547,7 +923,6 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
     else
     {
         /* invalid unicode codepoint */
-        *error_pointer = first_sequence;
         goto fail;
     }
 
@@ -577,17 +952,17 @@ fail:
 }
 
 /* Parse the input text into an unescaped cinput, and populate item. */
-static const unsigned char *parse_string(cJSON * const item, const unsigned char * const input, const unsigned char ** const error_pointer, const internal_hooks * const hooks)
+static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks)
 {
-    const unsigned char *input_pointer = input + 1;
-    const unsigned char *input_end = input + 1;
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *content_end = input_buffer->content + input_buffer->length;
     unsigned char *output_pointer = NULL;
     unsigned char *output = NULL;
 
     /* not a string */
-    if (*input != '\"')
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '\"'))
     {
-        *error_pointer = input;
         goto fail;
     }
 
@@ -595,12 +970,12 @@ static const unsigned char *parse_string(cJSON * const item, const unsigned char
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
-        while ((*input_end != '\"') && (*input_end != '\0'))
+        while ((input_end < content_end) && (*input_end != '\"'))
         {
             /* is escape sequence */
             if (input_end[0] == '\\')
             {
-                if (input_end[1] == '\0')
+                if ((input_end + 1) >= content_end)
                 {
                     /* prevent buffer overflow when last input character is a backslash */
                     goto fail;
@@ -610,17 +985,25 @@ static const unsigned char *parse_string(cJSON * const item, const unsigned char
             }
             input_end++;
         }
-        if (*input_end == '\0')
+        if (input_end >= content_end)
         {
             goto fail; /* string ended unexpectedly */
         }
 
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - input) - skipped_bytes;
-        output = (unsigned char*)hooks->allocate(allocation_length + sizeof('\0'));
-        if (output == NULL)
+        if (input_buffer->in_situ)
         {
-            goto fail; /* allocation failure */
+            /* unescaping never grows a string, the closing quote takes the terminator */
+            output = (unsigned char*)input_pointer;
+        }
+        else
+        {
+            /* This is at most how much we need for the output */
+            allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+            output = (unsigned char*)hooks->allocate(allocation_length + sizeof('\0'));
+            if (output == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
         }
     }
 
@@ -661,7 +1044,7 @@ static const unsigned char *parse_string(cJSON * const item, const unsigned char
 
                 /* UTF-16 literal */
                 case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer, error_pointer);
+                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
                     if (sequence_length == 0)
                     {
                         /* failed to convert UTF16-literal to UTF-8 */
@@ -670,7 +1053,6 @@ static const unsigned char *parse_string(cJSON * const item, const unsigned char
                     break;
 
                 default:
-                    *error_pointer = input_pointer;
                     goto fail;
             }
             input_pointer += sequence_length;
@@ -680,18 +1062,27 @@ static const unsigned char *parse_string(cJSON * const item, const unsigned char
     /* zero terminate the output */
     *output_pointer = '\0';
 
-    item->type = cJSON_String;
+    /* an in-situ string belongs to the input buffer, cJSON_Delete must not free it */
+    item->type = input_buffer->in_situ ? (cJSON_String | cJSON_IsReference) : cJSON_String;
     item->valuestring = (char*)output;
 
-    return input_end + 1;
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && !input_buffer->in_situ)
     {
         hooks->deallocate(output);
     }
 
-    return NULL;
+    if (input_pointer != NULL)
+    {
+        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+    }
+
+    return false;
 }
 
 /* Render the cstring provided to an escaped version that can be printed. */
@@ -813,62 +1204,131 @@ static cJSON_bool print_string(const cJSON * const item, printbuffer * const p,
 }
 
 /* Predeclare these prototypes. */
-static const unsigned char *parse_value(cJSON * const item, const unsigned char * const input, const unsigned char ** const ep, const internal_hooks * const hooks);
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks);
 static cJSON_bool print_value(const cJSON * const item, const size_t depth, const cJSON_bool format, printbuffer * const output_buffer, const internal_hooks * const hooks);
-static const unsigned char *parse_array(cJSON * const item, const unsigned char *input, const unsigned char ** const ep, const internal_hooks * const hooks);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks);
 static cJSON_bool print_array(const cJSON * const item, const size_t depth, const cJSON_bool format, printbuffer * const output_buffer, const internal_hooks * const hooks);
-static const unsigned char *parse_object(cJSON * const item, const unsigned char *input, const unsigned char ** const ep, const internal_hooks * const hooks);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks);
 static cJSON_bool print_object(const cJSON * const item, const size_t depth, const cJSON_bool format, printbuffer * const output_buffer, const internal_hooks * const hooks);
 
 /* Utility to jump whitespace and cr/lf */
-static const unsigned char *skip_whitespace(const unsigned char *in)
+static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
 {
-    while (in && *in && (*in <= 32))
+    if ((buffer == NULL) || (buffer->content == NULL))
+    {
+        return NULL;
+    }
+
+    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
     {
-        in++;
+        buffer->offset++;
     }
 
-    return in;
+    return buffer;
 }
 
 /* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse_root(const char *value, size_t buffer_length, const char * const *keep, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_bool in_situ)
 {
-    const unsigned char *end = NULL;
+    parse_buffer buffer;
+    cJSON *item = NULL;
     /* use global error pointer if no specific one was given */
     const unsigned char **ep = return_parse_end ? (const unsigned char**)return_parse_end : &global_ep;
-    cJSON *c = cJSON_New_Item(&global_hooks);
+
     *ep = NULL;
-    if (!c) /* memory fail */
+    if (value == NULL)
     {
         return NULL;
     }
 
-    end = parse_value(c, skip_whitespace((const unsigned char*)value), ep, &global_hooks);
-    if (!end)
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.in_situ = in_situ;
+    buffer.keep = NULL;
+    buffer.depth = 0;
+
+    item = cJSON_New_Item(&global_hooks);
+    if (item == NULL) /* memory fail */
     {
-        /* parse failure. ep is set. */
-        cJSON_Delete(c);
         return NULL;
     }
 
+    buffer_skip_whitespace(&buffer);
+    /* the filter applies to the members of a top level object only */
+    if (can_access_at_index(&buffer, 0) && (buffer_at_offset(&buffer)[0] == '{'))
+    {
+        buffer.keep = keep;
+    }
+
+    if (!parse_value(item, &buffer, &global_hooks))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+
     /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
     if (require_null_terminated)
     {
-        end = skip_whitespace(end);
-        if (*end)
+        buffer_skip_whitespace(&buffer);
+        if (can_access_at_index(&buffer, 0) && (buffer_at_offset(&buffer)[0] != '\0'))
         {
-            cJSON_Delete(c);
-            *ep = end;
-            return NULL;
+            goto fail;
         }
     }
     if (return_parse_end)
     {
-        *return_parse_end = (const char*)end;
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
     }
 
-    return c;
+    return item;
+
+fail:
+    cJSON_Delete(item);
+
+    /* the offset can be one past the end when the input ran out, point at the last byte then */
+    if ((buffer.offset >= buffer.length) && (buffer.length > 0))
+    {
+        buffer.offset = buffer.length - 1;
+    }
+    *ep = buffer_at_offset(&buffer);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_root(value, buffer_length, NULL, return_parse_end, require_null_terminated, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length)
+{
+    return parse_root(value, buffer_length, NULL, 0, 0, true);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituOpts(char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_root(value, buffer_length, NULL, return_parse_end, require_null_terminated, true);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseFilteredOpts(const char *value, size_t buffer_length, const char * const *keep, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_root(value, buffer_length, keep, return_parse_end, require_null_terminated, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituFilteredOpts(char *value, size_t buffer_length, const char * const *keep, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_root(value, buffer_length, keep, return_parse_end, require_null_terminated, true);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    if (value == NULL)
+    {
+        return NULL;
+    }
+
+    return cJSON_ParseWithLengthOpts(value, strlen(value), return_parse_end, require_null_terminated);
 }
 
 /* Default options for cJSON_Parse */
@@ -877,6 +1337,11 @@ CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
     return cJSON_ParseWithOpts(value, 0, 0);
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+{
+    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+}
+
 #define min(a, b) ((a < b) ? a : b)
 
 static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
@@ -983,57 +1448,257 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buf, const i
 }
 
 /* Parser core - when encountering text, process appropriately. */
-static const unsigned  char *parse_value(cJSON * const item, const unsigned char * const input, const unsigned char ** const error_pointer, const internal_hooks * const hooks)
+/* Skipping checks a value the way parsing it would and moves past it, without allocating anything. Nesting
+ * counts against CJSON_NESTING_LIMIT as in parsing, \u escapes are only checked for their hex digits. */
+static cJSON_bool skip_value(parse_buffer * const input_buffer);
+
+static cJSON_bool skip_string(parse_buffer * const input_buffer)
 {
-    if (input == NULL)
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '\"'))
+    {
+        return false;
+    }
+    input_buffer->offset++;
+
+    while (can_access_at_index(input_buffer, 0))
+    {
+        switch (buffer_at_offset(input_buffer)[0])
+        {
+            case '\"':
+                input_buffer->offset++;
+                return true;
+
+            case '\\':
+                if (cannot_access_at_index(input_buffer, 1))
+                {
+                    return false;
+                }
+                switch (buffer_at_offset(input_buffer)[1])
+                {
+                    case 'b':
+                    case 'f':
+                    case 'n':
+                    case 'r':
+                    case 't':
+                    case '\"':
+                    case '\\':
+                    case '/':
+                        input_buffer->offset += 2;
+                        break;
+
+                    case 'u':
+                        if (cannot_access_at_index(input_buffer, 5)
+                            || !isxdigit(buffer_at_offset(input_buffer)[2]) || !isxdigit(buffer_at_offset(input_buffer)[3])
+                            || !isxdigit(buffer_at_offset(input_buffer)[4]) || !isxdigit(buffer_at_offset(input_buffer)[5]))
+                        {
+                            return false;
+                        }
+                        input_buffer->offset += 6;
+                        break;
+
+                    default:
+                        return false;
+                }
+                break;
+
+            default:
+                input_buffer->offset++;
+                break;
+        }
+    }
+
+    return false; /* string ended unexpectedly */
+}
+
+/* parse_number into a scratch item, so a skipped number is accepted exactly when parsing would accept it.
+ * Like parse_value only a minus or a digit starts a number, parse_number would also take strtod's +1 and .5 */
+static cJSON_bool skip_number(parse_buffer * const input_buffer)
+{
+    cJSON number;
+
+    if ((buffer_at_offset(input_buffer)[0] != '-') && ((buffer_at_offset(input_buffer)[0] < '0') || (buffer_at_offset(input_buffer)[0] > '9')))
+    {
+        return false;
+    }
+
+    return parse_number(&number, input_buffer);
+}
+
+/* the elements of an array or the members of an object, input_buffer is at the opening bracket */
+static cJSON_bool skip_container(parse_buffer * const input_buffer, const unsigned char close)
+{
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        return false; /* too deeply nested, like parsing it */
+    }
+    input_buffer->depth++;
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == close))
+    {
+        input_buffer->offset++;
+        input_buffer->depth--;
+        return true; /* empty */
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    do
+    {
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (close == '}')
+        {
+            if (!skip_string(input_buffer))
+            {
+                return false;
+            }
+            buffer_skip_whitespace(input_buffer);
+            if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+            {
+                return false;
+            }
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+        }
+        if (!skip_value(input_buffer))
+        {
+            return false;
+        }
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != close))
+    {
+        return false;
+    }
+    input_buffer->offset++;
+    input_buffer->depth--;
+
+    return true;
+}
+
+static cJSON_bool skip_value(parse_buffer * const input_buffer)
+{
+    if (can_read(input_buffer, 4) && ((strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0) || (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0)))
+    {
+        input_buffer->offset += 4;
+        return true;
+    }
+    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+    {
+        input_buffer->offset += 5;
+        return true;
+    }
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        return false;
+    }
+
+    switch (buffer_at_offset(input_buffer)[0])
+    {
+        case '\"':
+            return skip_string(input_buffer);
+        case '[':
+            return skip_container(input_buffer, ']');
+        case '{':
+            return skip_container(input_buffer, '}');
+        default:
+            return skip_number(input_buffer);
+    }
+}
+
+/* true when the name input_buffer is at is one of keep, names with escapes are always kept and parsed */
+static cJSON_bool keep_member(const char * const *keep, const parse_buffer * const input_buffer)
+{
+    const unsigned char *name = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *content_end = input_buffer->content + input_buffer->length;
+    size_t length = 0;
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '\"'))
+    {
+        return true; /* not a name, parse_string reports it */
+    }
+    while (((name + length) < content_end) && (name[length] != '\"'))
+    {
+        if (name[length] == '\\')
+        {
+            return true;
+        }
+        length++;
+    }
+
+    for (; *keep != NULL; keep++)
+    {
+        size_t i = 0;
+        while ((i < length) && ((*keep)[i] != '\0') && (tolower(name[i]) == tolower((unsigned char)(*keep)[i])))
+        {
+            i++;
+        }
+        if ((i == length) && ((*keep)[i] == '\0'))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks)
+{
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
     {
-        return NULL; /* no input */
+        return false; /* no input */
     }
 
     /* parse the different types of values */
     /* null */
-    if (!strncmp((const char*)input, "null", 4))
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
     {
         item->type = cJSON_NULL;
-        return input + 4;
+        input_buffer->offset += 4;
+        return true;
     }
     /* false */
-    if (!strncmp((const char*)input, "false", 5))
+    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
     {
         item->type = cJSON_False;
-        return input + 5;
+        input_buffer->offset += 5;
+        return true;
     }
     /* true */
-    if (!strncmp((const char*)input, "true", 4))
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
     {
         item->type = cJSON_True;
         item->valueint = 1;
-        return input + 4;
+        input_buffer->offset += 4;
+        return true;
     }
     /* string */
-    if (*input == '\"')
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
     {
-        return parse_string(item, input, error_pointer, hooks);
+        return parse_string(item, input_buffer, hooks);
     }
     /* number */
-    if ((*input == '-') || ((*input >= '0') && (*input <= '9')))
+    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9'))))
     {
-        return parse_number(item, input);
+        return parse_number(item, input_buffer);
     }
     /* array */
-    if (*input == '[')
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
     {
-        return parse_array(item, input, error_pointer, hooks);
+        return parse_array(item, input_buffer, hooks);
     }
     /* object */
-    if (*input == '{')
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
     {
-        return parse_object(item, input, error_pointer, hooks);
+        return parse_object(item, input_buffer, hooks);
     }
 
     /* failure. */
-    *error_pointer = input;
-    return NULL;
+    return false;
 }
 
 /* Render a value to text. */
@@ -1115,27 +1780,39 @@ static cJSON_bool print_value(const cJSON * const item, const size_t depth, cons
 }
 
 /* Build an array from input text. */
-static const unsigned char *parse_array(cJSON * const item, const unsigned char *input, const unsigned char ** const error_pointer, const internal_hooks * const hooks)
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks)
 {
     cJSON *head = NULL; /* head of the linked list */
     cJSON *current_item = NULL;
 
-    if (*input != '[')
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        return false; /* too deeply nested */
+    }
+
+    if (buffer_at_offset(input_buffer)[0] != '[')
     {
         /* not an array */
-        *error_pointer = input;
         goto fail;
     }
 
-    input = skip_whitespace(input + 1);
-    if (*input == ']')
+    input_buffer->depth++;
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
     {
         /* empty array */
         goto success;
     }
 
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        goto fail;
+    }
+
     /* step back to character in front of the first element */
-    input--;
+    input_buffer->offset--;
     /* loop through the comma separated array elements */
     do
     {
@@ -1161,27 +1838,30 @@ static const unsigned char *parse_array(cJSON * const item, const unsigned char
         }
 
         /* parse next value */
-        input = skip_whitespace(input + 1);
-        input = parse_value(current_item, input, error_pointer, hooks);
-        input = skip_whitespace(input);
-        if (input == NULL)
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_value(current_item, input_buffer, hooks))
         {
             goto fail; /* failed to parse value */
         }
+        buffer_skip_whitespace(input_buffer);
     }
-    while (*input == ',');
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
 
-    if (*input != ']')
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ']'))
     {
-        *error_pointer = input;
         goto fail; /* expected end of array */
     }
 
 success:
+    input_buffer->depth--;
+
     item->type = cJSON_Array;
     item->child = head;
 
-    return input + 1;
+    input_buffer->offset++;
+
+    return true;
 
 fail:
     if (head != NULL)
@@ -1189,7 +1869,7 @@ fail:
         cJSON_Delete(head);
     }
 
-    return NULL;
+    return false;
 }
 
 /* Render an array to text */
@@ -1253,30 +1933,71 @@ static cJSON_bool print_array(const cJSON * const item, const size_t depth, cons
 }
 
 /* Build an object from the text. */
-static const unsigned char *parse_object(cJSON * const item, const unsigned char *input, const unsigned char ** const error_pointer, const internal_hooks * const hooks)
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer, const internal_hooks * const hooks)
 {
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
+    /* only the top level object is filtered, nested ones find keep cleared */
+    const char * const *keep = input_buffer->keep;
 
-    if (*input != '{')
+    input_buffer->keep = NULL;
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        return false; /* too deeply nested */
+    }
+
+    if (buffer_at_offset(input_buffer)[0] != '{')
     {
-        *error_pointer = input;
         goto fail; /* not an object */
     }
 
-    input = skip_whitespace(input + 1);
-    if (*input == '}')
+    input_buffer->depth++;
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
     {
         goto success; /* empty object */
     }
 
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        goto fail;
+    }
+
     /* step back to character in front of the first element */
-    input--;
+    input_buffer->offset--;
     /* loop through the comma separated array elements */
     do
     {
+        cJSON *new_item = NULL;
+
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if ((keep != NULL) && !keep_member(keep, input_buffer))
+        {
+            /* checked and passed over, the loop condition looks for the next member */
+            if (!skip_string(input_buffer))
+            {
+                goto fail;
+            }
+            buffer_skip_whitespace(input_buffer);
+            if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+            {
+                goto fail;
+            }
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+            if (!skip_value(input_buffer))
+            {
+                goto fail;
+            }
+            buffer_skip_whitespace(input_buffer);
+            continue;
+        }
+
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(hooks);
+        new_item = cJSON_New_Item(hooks);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1297,46 +2018,57 @@ static const unsigned char *parse_object(cJSON * const item, const unsigned char
         }
 
         /* parse the name of the child */
-        input = skip_whitespace(input + 1);
-        input = parse_string(current_item, input, error_pointer, hooks);
-        input = skip_whitespace(input);
-        if (input == NULL)
+        if (!parse_string(current_item, input_buffer, hooks))
         {
             goto fail; /* faile to parse name */
         }
+        buffer_skip_whitespace(input_buffer);
 
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ)
+        {
+            /* keeps cJSON_Delete off the name should the value fail to parse */
+            current_item->type = cJSON_StringIsConst;
+        }
 
-        if (*input != ':')
+        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
-            *error_pointer = input;
             goto fail; /* invalid object */
         }
 
         /* parse the value */
-        input = skip_whitespace(input + 1);
-        input = parse_value(current_item, input, error_pointer, hooks);
-        input = skip_whitespace(input);
-        if (input == NULL)
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_value(current_item, input_buffer, hooks))
         {
             goto fail; /* failed to parse value */
         }
+        buffer_skip_whitespace(input_buffer);
+
+        if (input_buffer->in_situ)
+        {
+            /* parse_value set the type, the name still points into the input buffer */
+            current_item->type |= cJSON_StringIsConst;
+        }
     }
-    while (*input == ',');
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
 
-    if (*input != '}')
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
     {
-        *error_pointer = input;
         goto fail; /* expected end of object */
     }
 
 success:
+    input_buffer->depth--;
+
     item->type = cJSON_Object;
     item->child = head;
 
-    return input + 1;
+    input_buffer->offset++;
+
+    return true;
 
 fail:
     if (head != NULL)
@@ -1344,7 +2076,7 @@ fail:
         cJSON_Delete(head);
     }
 
-    return NULL;
+    return false;
 }
 
 /* Render an object to text. */
@@ -1464,6 +2196,14 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 {
     cJSON *c = array->child;
     size_t i = 0;
+
+#ifdef CJSON_OBJECT_INDEX
+    if (array->index != NULL)
+    {
+        return (int)array->index->count;
+    }
+#endif
+
     while(c)
     {
         i++;
@@ -1478,43 +2218,92 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int item)
 {
     cJSON *c = array ? array->child : NULL;
-    while (c && item > 0)
+
+#ifdef CJSON_OBJECT_INDEX
+    if ((c != NULL) && ((array->type & 0xFF) == cJSON_Array) && (item >= 0))
     {
-        item--;
-        c = c->next;
+        if (array->index != NULL)
+        {
+            return ((size_t)item < array->index->count) ? array->index->slots[item].item : NULL;
+        }
+        if (item >= CJSON_INDEX_MIN_MEMBERS)
+        {
+            index_build((cJSON*)array);
+            if (array->index != NULL)
+            {
+                return ((size_t)item < array->index->count) ? array->index->slots[item].item : NULL;
+            }
+        }
     }
+#endif
 
-    return c;
-}
-
-CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON *object, const char *string)
-{
-    cJSON *c = object ? object->child : NULL;
-    while (c && cJSON_strcasecmp((unsigned char*)c->string, (const unsigned char*)string))
+    while (c && item > 0)
     {
+        item--;
         c = c->next;
     }
+
     return c;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string)
+static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    size_t walked = 0;
 
-    if ((object == NULL) || (string == NULL))
+    if ((object == NULL) || (name == NULL))
     {
         return NULL;
     }
 
+#ifdef CJSON_OBJECT_INDEX
+    if ((object->index != NULL) && ((object->type & 0xFF) == cJSON_Object))
+    {
+        return index_lookup(object->index, name, case_sensitive);
+    }
+#endif
+
     current_element = object->child;
-    while ((current_element != NULL) && (strcmp(string, current_element->string) != 0))
+    if (case_sensitive)
     {
-        current_element = current_element->next;
+        while ((current_element != NULL) && ((current_element->string == NULL) || (strcmp(name, current_element->string) != 0)))
+        {
+            current_element = current_element->next;
+            walked++;
+        }
+    }
+    else
+    {
+        while ((current_element != NULL) && cJSON_strcasecmp((const unsigned char*)current_element->string, (const unsigned char*)name))
+        {
+            current_element = current_element->next;
+            walked++;
+        }
     }
 
+#ifdef CJSON_OBJECT_INDEX
+    /* only objects a lookup had to walk far into get an index, small ones keep scanning */
+    if ((walked >= CJSON_INDEX_MIN_MEMBERS) && ((object->type & 0xFF) == cJSON_Object))
+    {
+        index_build((cJSON*)object);
+    }
+#else
+    (void)walked;
+#endif
+
     return current_element;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    return get_object_item(object, string, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string)
+{
+    return get_object_item(object, string, true);
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string)
 {
     return cJSON_GetObjectItem(object, string) ? 1 : 0;
@@ -1539,6 +2328,10 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
     ref->string = NULL;
     ref->type |= cJSON_IsReference;
     ref->next = ref->prev = NULL;
+#ifdef CJSON_OBJECT_INDEX
+    /* the index belongs to item, a reference never builds its own */
+    ref->index = NULL;
+#endif
     return ref;
 }
 
@@ -1551,6 +2344,7 @@ CJSON_PUBLIC(void) cJSON_AddItemToArray(cJSON *array, cJSON *item)
     {
         return;
     }
+    index_drop(array);
 
     child = array->child;
 
@@ -1620,6 +2414,7 @@ static cJSON *DetachItemFromArray(cJSON *array, size_t which)
         /* item doesn't exist */
         return NULL;
     }
+    index_drop(array);
     if (c->prev)
     {
         /* not the first element */
@@ -1689,6 +2484,7 @@ CJSON_PUBLIC(void) cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newit
         cJSON_AddItemToArray(array, newitem);
         return;
     }
+    index_drop(array);
     newitem->next = c;
     newitem->prev = c->prev;
     c->prev = newitem;
@@ -1714,6 +2510,7 @@ static void ReplaceItemInArray(cJSON *array, size_t which, cJSON *newitem)
     {
         return;
     }
+    index_drop(array);
     newitem->next = c->next;
     newitem->prev = c->prev;
     if (newitem->next)
@@ -1808,13 +2605,16 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool b)
     return item;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(cJSON_number num)
 {
     cJSON *item = cJSON_New_Item(&global_hooks);
     if(item)
     {
         item->type = cJSON_Number;
         item->valuedouble = num;
+#ifdef CJSON_INT_ONLY
+        item->valueint = num;
+#else
 
         /* use saturation in case of overflow */
         if (num >= INT_MAX)
@@ -1829,6 +2629,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
         {
             item->valueint = (int)num;
         }
+#endif
     }
 
     return item;
@@ -1926,6 +2727,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count)
     return a;
 }
 
+#ifndef CJSON_INT_ONLY
 CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count)
 {
     size_t i = 0;
@@ -1942,7 +2744,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count)
 
     for(i = 0; a && (i < (size_t)count); i++)
     {
-        n = cJSON_CreateNumber((double)numbers[i]);
+        n = cJSON_CreateNumber((cJSON_number)numbers[i]);
         if(!n)
         {
             cJSON_Delete(a);
@@ -1997,6 +2799,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count)
 
     return a;
 }
+#endif
 
 CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char **strings, int count)
 {
@@ -35,6 +35,30 @@ extern "C"
 
 #include <stddef.h>
 
+/* Define CJSON_INT_ONLY for a build without floating point. Numbers are ints: they are parsed without
+ * strtod, fractions are truncated and valuedouble holds the same int as valueint. */
+#ifdef CJSON_INT_ONLY
+typedef int cJSON_number;
+#else
+typedef double cJSON_number;
+#endif
+
+/* Define CJSON_OBJECT_INDEX to let large objects and arrays keep an index of their members. One is built when
+ * a lookup had to walk CJSON_INDEX_MIN_MEMBERS members: later object lookups then cost one hash of the name,
+ * cJSON_GetArrayItem and cJSON_GetArraySize on an array become O(1). The index is dropped by every cJSON
+ * function that adds, removes or replaces members; members linked in or renamed by hand leave it stale. */
+#ifdef CJSON_OBJECT_INDEX
+#ifndef CJSON_INDEX_MIN_MEMBERS
+#define CJSON_INDEX_MIN_MEMBERS 8
+#endif
+#endif
+
+/* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
+ * This is to prevent stack overflows, every level costs a recursion of the parser. */
+#ifndef CJSON_NESTING_LIMIT
+#define CJSON_NESTING_LIMIT 1000
+#endif
+
 /* cJSON Types: */
 #define cJSON_Invalid (0)
 #define cJSON_False  (1 << 0)
@@ -66,10 +90,14 @@ typedef struct cJSON
     /* The item's number, if type==cJSON_Number */
     int valueint;
     /* The item's number, if type==cJSON_Number */
-    double valuedouble;
+    cJSON_number valuedouble;
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+#ifdef CJSON_OBJECT_INDEX
+    /* Index of the members of an object or array, private to cJSON. */
+    struct cJSON_Index *index;
+#endif
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -122,6 +150,10 @@ CJSON_PUBLIC(const char*) cJSON_Version(void);
 
 /* Supply malloc, realloc and free functions to cJSON */
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks);
+/* Supply malloc and free functions for the nodes alone, every malloc_fn call asks for sizeof(cJSON). Strings
+ * and buffers keep using the hooks above, as do nodes when hooks is NULL or lacks a function. Set before the
+ * first node is allocated, a node is freed with the function of the hooks it came from. */
+CJSON_PUBLIC(void) cJSON_InitNodeHooks(cJSON_Hooks* hooks);
 
 
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. Call cJSON_Delete when finished. */
@@ -165,7 +197,7 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateTrue(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateFalse(void);
 CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean);
-CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num);
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(cJSON_number num);
 CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string);
 /* raw json */
 CJSON_PUBLIC(cJSON *) cJSON_CreateRaw(const char *raw);
@@ -174,8 +206,10 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateObject(void);
 
 /* These utilities create an Array of count items. */
 CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count);
+#ifndef CJSON_INT_ONLY
 CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count);
 CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count);
+#endif
 CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char **strings, int count);
 
 /* Append item to the specified array/object. */
@@ -209,6 +243,18 @@ The item->next and ->prev pointers are always zero on return from Duplicate. */
 /* ParseWithOpts allows you to require (and check) that the JSON is null terminated, and to retrieve the pointer to the final byte parsed. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error. If not, then cJSON_GetErrorPtr() does the job. */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* ParseWithLength parses a buffer that does not have to be null terminated, not a byte past value + buffer_length is read. */
+/* With require_null_terminated only whitespace or a null terminator may follow the JSON inside the buffer. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* ParseInSitu unescapes strings inside value instead of allocating them, valuestring and string point into value. */
+/* The buffer is modified and must outlive the returned tree. Items that own no string carry cJSON_IsReference (values) or cJSON_StringIsConst (names). */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituOpts(char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* ParseFiltered keeps only the members of a top level object named in keep, a NULL terminated list matched case-insensitively. */
+/* The values of the other members are checked for valid syntax and skipped, no item or string is allocated for them. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseFilteredOpts(const char *value, size_t buffer_length, const char * const *keep, const char **return_parse_end, cJSON_bool require_null_terminated);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituFilteredOpts(char *value, size_t buffer_length, const char * const *keep, const char **return_parse_end, cJSON_bool require_null_terminated);
 
 CJSON_PUBLIC(void) cJSON_Minify(char *json);
 
@@ -224,10 +270,11 @@ CJSON_PUBLIC(void) cJSON_Minify(char *json);
 /* When assigning an integer value, it needs to be propagated to valuedouble too. */
 #define cJSON_SetIntValue(object, number) ((object) ? (object)->valueint = (object)->valuedouble = (number) : (number))
 /* helper for the cJSON_SetNumberValue macro */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number);
-#define cJSON_SetNumberValue(object, number) ((object != NULL) ? cJSON_SetNumberHelper(object, (double)number) : (number))
+CJSON_PUBLIC(cJSON_number) cJSON_SetNumberHelper(cJSON *object, cJSON_number number);
+#define cJSON_SetNumberValue(object, number) ((object != NULL) ? cJSON_SetNumberHelper(object, (cJSON_number)number) : (number))
 
-/* Macro for iterating over an array */
+/* Macro for iterating over an array or object, a single walk of the list where a loop over
+ * cJSON_GetArrayItem walks it again for every element */
 #define cJSON_ArrayForEach(element, array) for(element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
 
 #ifdef __cplusplus
@@ -0,0 +1,259 @@
+/*
+ * commandStream.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Pulls the tokens of a request from jsonPull and writes the members of each
+ *  command straight into a batch entry, no tree is built and nothing is
+ *  allocated. Only the plain command schema is known here, a request that uses
+ *  more (fades, schedules, policies, jobs, keys) is handed back as unsupported
+ *  and goes through cJSON instead, so does a number that is not a plain integer.
+ *  Values follow the cJSON path: same defaults, same clamping, and a command
+ *  without protocol, value, unit or address is skipped.
+ */
+#include <string.h>
+#include "commandStream.h"
+#include "rfProtocol.h"
+
+enum commandStreamStates
+{
+	STREAM_START = 0,
+	STREAM_TOP,				//members of the request
+	STREAM_OPTIMIZE,		//value of "optimize"
+	STREAM_COMMANDS,		//value of "commands"
+	STREAM_ARRAY,			//elements of "commands"
+	STREAM_COMMAND,			//members of a command
+	STREAM_VALUE,			//value of a member of a command
+	STREAM_DONE
+};
+
+enum commandStreamFields
+{
+	FIELD_PROTOCOL = 0,
+	FIELD_TYPE,
+	FIELD_VALUE,
+	FIELD_UNIT,
+	FIELD_ADDRESS,
+	FIELD_REPEAT,
+	FIELD_GROUP,
+	FIELD_ORDERED,
+	FIELDS
+};
+
+#define FIELD_BIT(field)	((uint16_t)1 << (field))
+#define FIELDS_REQUIRED		(FIELD_BIT(FIELD_PROTOCOL) | FIELD_BIT(FIELD_VALUE) | FIELD_BIT(FIELD_UNIT) | FIELD_BIT(FIELD_ADDRESS))
+
+static const char * const fieldNames[FIELDS] = { "protocol", "type", "value", "unit", "address", "repeat", "group", "ordered" };
+
+static int commandStream_field(const char * name)
+{
+	int i;
+
+	for(i = 0; i < FIELDS; i++){
+		if(strcmp(name, fieldNames[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * @brief first required field that was not seen, in the order the cJSON path checks them
+ */
+static const char * commandStream_missing(uint16_t seen)
+{
+	int i;
+
+	for(i = 0; i < FIELDS; i++){
+		if((FIELDS_REQUIRED & FIELD_BIT(i)) && !(seen & FIELD_BIT(i)))
+			return fieldNames[i];
+	}
+	return NULL;
+}
+
+static uint8_t commandStream_clamp(int32_t value)
+{
+	return value < 0 ? 0 : (value > UINT8_MAX ? UINT8_MAX : value);
+}
+
+/*
+ * @brief true when the number is a plain integer of at most 9 digits
+ *
+ * only those are read here, their integral part is the whole value exactly as
+ * parse_number has it. Fractions, exponents and larger numbers go through cJSON
+ */
+static int commandStream_plain(const jsonPull * json)
+{
+	const char * digits = json->text[0] == '-' ? json->text + 1 : json->text;
+
+	return !json->truncated && strlen(digits) <= 9 && strspn(digits, "0123456789") == strlen(digits);
+}
+
+/*
+ * @brief true like cJSON_IsTrue, a value that needs skipping cannot be read here
+ */
+static int commandStream_flag(int token, int * flag)
+{
+	if(token == JSONPULL_OBJECT || token == JSONPULL_ARRAY)
+		return 0;
+	*flag = token == JSONPULL_TRUE;
+	return 1;
+}
+
+/*
+ * @brief store the value token of a member of the command, returns 0 when the stream cannot read it
+ */
+static int commandStream_value(commandStream * stream, int token)
+{
+	RFcommand * command = &stream->entry.command;
+	jsonPull * json = &stream->json;
+	int flag;
+
+	switch(stream->field){
+	case FIELD_PROTOCOL:
+		if(token != JSONPULL_STRING)
+			return 0;
+		command->protocol = rfProtocol_id(json->text);
+		strcpy(stream->protocol, json->text);
+		return 1;
+	case FIELD_TYPE:
+		if(token != JSONPULL_STRING)
+			return 0;
+		command->type = frameDispatcher_type_id(json->text);
+		return 1;
+	case FIELD_GROUP:
+		if(!commandStream_flag(token, &flag))
+			return 0;
+		command->group = flag;
+		return 1;
+	case FIELD_ORDERED:
+		return commandStream_flag(token, &stream->entry.ordered);
+	default:
+		break;
+	}
+
+	if(token != JSONPULL_NUMBER || !commandStream_plain(json))
+		return 0;
+	switch(stream->field){
+	case FIELD_VALUE:
+		command->value = commandStream_clamp(json->integer);
+		break;
+	case FIELD_UNIT:
+		command->unit = json->integer;
+		break;
+	case FIELD_ADDRESS:
+		command->address = json->integer;
+		break;
+	default:
+		command->repetitions = commandStream_clamp(json->integer);
+		break;
+	}
+	return 1;
+}
+
+void commandStream_init(commandStream * stream, const batchEntry * defaults)
+{
+	memset(stream, 0, sizeof(commandStream));
+	jsonPull_init(&stream->json);
+	stream->defaults = defaults;
+}
+
+void commandStream_feed(commandStream * stream, const char * data, size_t length)
+{
+	jsonPull_feed(&stream->json, data, length);
+}
+
+/*
+ * @brief read up to the next complete command of the request
+ *
+ * a command with an unknown protocol is returned as RF_PROTOCOL_UNKNOWN with its
+ * name in protocol, so the caller can reject the request like the cJSON path does
+ */
+int commandStream_next(commandStream * stream, batchEntry * entry)
+{
+	int token;
+
+	for(;;){
+		if((token = jsonPull_next(&stream->json)) == JSONPULL_MORE)
+			return COMMANDSTREAM_MORE;
+		if(token == JSONPULL_ERROR)
+			return COMMANDSTREAM_ERROR;
+
+		switch(stream->state){
+		case STREAM_START:
+			if(token != JSONPULL_OBJECT)
+				return COMMANDSTREAM_UNSUPPORTED;
+			stream->state = STREAM_TOP;
+			break;
+
+		case STREAM_TOP:
+			if(token == JSONPULL_OBJECT_END){
+				stream->state = STREAM_DONE;
+			}else if(strcmp(stream->json.text, "commands") == 0 && !stream->has_commands){
+				stream->has_commands = 1;
+				stream->state = STREAM_COMMANDS;
+			}else if(strcmp(stream->json.text, "optimize") == 0){
+				stream->state = STREAM_OPTIMIZE;
+			}else{
+				return COMMANDSTREAM_UNSUPPORTED;
+			}
+			break;
+
+		case STREAM_OPTIMIZE:
+			if(!commandStream_flag(token, &stream->optimize))
+				return COMMANDSTREAM_UNSUPPORTED;
+			stream->state = STREAM_TOP;
+			break;
+
+		case STREAM_COMMANDS:
+			if(token != JSONPULL_ARRAY)
+				return COMMANDSTREAM_UNSUPPORTED;
+			stream->state = STREAM_ARRAY;
+			break;
+
+		case STREAM_ARRAY:
+			if(token == JSONPULL_ARRAY_END){
+				stream->state = STREAM_TOP;
+				break;
+			}
+			if(token != JSONPULL_OBJECT)
+				return COMMANDSTREAM_UNSUPPORTED;
+			stream->commands++;
+			stream->entry = *stream->defaults;
+			stream->entry.command.type = RF_TYPE_DIMMER;
+			stream->entry.command.repetitions = 25;
+			stream->seen = 0;
+			stream->state = STREAM_COMMAND;
+			break;
+
+		case STREAM_COMMAND:
+			if(token == JSONPULL_OBJECT_END){
+				stream->state = STREAM_ARRAY;
+				//an unknown protocol rejects the request even when the command is incomplete
+				if(!(stream->seen & FIELD_BIT(FIELD_PROTOCOL)) || (stream->entry.command.protocol != RF_PROTOCOL_UNKNOWN
+						&& (stream->seen & FIELDS_REQUIRED) != FIELDS_REQUIRED)){
+					stream->missing = commandStream_missing(stream->seen);
+					return COMMANDSTREAM_SKIPPED;
+				}
+				*entry = stream->entry;
+				return COMMANDSTREAM_COMMAND;
+			}
+			//cJSON matches names case-insensitively and takes the first of duplicates, leave those to it
+			if((stream->field = commandStream_field(stream->json.text)) < 0 || (stream->seen & FIELD_BIT(stream->field)))
+				return COMMANDSTREAM_UNSUPPORTED;
+			stream->seen |= FIELD_BIT(stream->field);
+			stream->state = STREAM_VALUE;
+			break;
+
+		case STREAM_VALUE:
+			if(!commandStream_value(stream, token))
+				return COMMANDSTREAM_UNSUPPORTED;
+			stream->state = STREAM_COMMAND;
+			break;
+
+		default:
+			if(token == JSONPULL_END)
+				return COMMANDSTREAM_END;
+			break;
+		}
+	}
+}
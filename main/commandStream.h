@@ -0,0 +1,47 @@
+/*
+ * commandStream.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_COMMANDSTREAM_H_
+#define MAIN_COMMANDSTREAM_H_
+
+#include "jsonPull.h"
+#include "batchOptimizer.h"
+
+enum commandStreamResults
+{
+	COMMANDSTREAM_MORE = 0,		//feed the next chunk
+	COMMANDSTREAM_COMMAND,		//a command was read
+	COMMANDSTREAM_SKIPPED,		//a command lacks the field in missing and is left out
+	COMMANDSTREAM_END,			//the request is complete
+	COMMANDSTREAM_UNSUPPORTED,	//the request uses a field the stream does not read, parse it as a tree
+	COMMANDSTREAM_ERROR			//not valid json
+};
+
+/* reads the commands of a plain request straight into batch entries
+ *
+ * only "commands" with protocol, type, value, unit, address, repeat, group and
+ * ordered plus a top level "optimize" are read, anything else is reported as
+ * unsupported before a command of the request had any effect
+ */
+typedef struct {
+		jsonPull json;
+		int state;
+		int field;					//member whose value comes next
+		uint16_t seen;				//members of the command read so far
+		int commands;				//elements of the commands array
+		int has_commands;
+		int optimize;
+		const batchEntry * defaults;
+		batchEntry entry;
+		char protocol[JSONPULL_TEXT_SIZE];	//name of the protocol of the command
+		const char * missing;		//first required field a skipped command lacks
+}commandStream;
+
+void commandStream_init(commandStream * stream, const batchEntry * defaults);
+void commandStream_feed(commandStream * stream, const char * data, size_t length);
+int commandStream_next(commandStream * stream, batchEntry * entry);
+
+#endif /* MAIN_COMMANDSTREAM_H_ */
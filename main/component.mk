@@ -2,3 +2,12 @@
 # Main Makefile. This is basically the same as a component makefile.
 #
 # (Uses default behaviour of compiling all source files in directory, adding 'include' to include path.)
+
+# Uncomment to build cJSON without floating point, numbers are parsed and kept as ints.
+#CFLAGS += -DCJSON_INT_ONLY
+
+# Uncomment to let cJSON objects with many members keep a hash index for lookups.
+#CFLAGS += -DCJSON_OBJECT_INDEX
+
+# cJSON recurses once per nested array or object, deeper requests are rejected before they outgrow the stack of a handler.
+CFLAGS += -DCJSON_NESTING_LIMIT=8
@@ -0,0 +1,279 @@
+/*
+ * fadeEngine.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Generates the intermediate dim frames of a fade inside the dispatcher. The
+ *  parser, or the scheduler for every run of a delayed fade, only reserves a
+ *  fade slot for the unit and queues the target command with the slot number,
+ *  the worker of the protocol activates the slot when it dequeues it and is the
+ *  only one that steps the slot until the fade ends. Steps are paced
+ *  to be at least one step's air time apart, the level of a step is always taken
+ *  from the curve at the moment it is sent so late steps are dropped instead of
+ *  piling up, and intermediate steps are skipped while other commands are queued.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "fadeEngine.h"
+#include "jobTracker.h"
+
+#define FADE_SCALE		1024	/*!< fixed point 1.0 for the curves */
+
+enum fadeStates
+{
+	FADE_FREE = 0,
+	FADE_RESERVED,		//parameters and unit set by the parser, waiting for the dispatcher
+	FADE_ACTIVE
+};
+
+typedef struct {
+		RFcommand command;		//target, value is the final level
+		int from;
+		int last;				//level that went on air last
+		int curve;
+		uint32_t duration_ms;
+		TickType_t start;
+		TickType_t duration;
+		TickType_t step;		//ticks between steps
+		TickType_t next;		//tick of the next step
+		int state;
+}fade;
+
+static fade fades[FADE_MAX_FADES];
+static portMUX_TYPE fadeMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char * const curveNames[] = { "linear", "ease-in", "ease-out", "ease" };
+
+/*
+ * @brief curve id by name, linear when unknown
+ */
+int fadeEngine_curve(const char * name)
+{
+	int i;
+
+	for(i = 0; name != NULL && i < (int)(sizeof(curveNames) / sizeof(curveNames[0])); i++){
+		if(strcmp(name, curveNames[i]) == 0)
+			return i;
+	}
+	return FADE_LINEAR;
+}
+
+/*
+ * @brief progress [0..FADE_SCALE] mapped through the curve
+ */
+static int fade_curve(int curve, int p)
+{
+	switch(curve){
+	case FADE_EASE_IN:
+		return p * p / FADE_SCALE;
+	case FADE_EASE_OUT:
+		return FADE_SCALE - (FADE_SCALE - p) * (FADE_SCALE - p) / FADE_SCALE;
+	case FADE_EASE:
+		return (3 * FADE_SCALE - 2 * p) * (p * p / FADE_SCALE) / FADE_SCALE;
+	default:
+		return p;
+	}
+}
+
+static int fade_level(const fade * f, TickType_t now)
+{
+	int p = (int)((uint64_t)(now - f->start) * FADE_SCALE / f->duration);
+	int to = f->command.value;
+
+	p = fade_curve(f->curve, p);
+	return f->from + ((to - f->from) * p + (to > f->from ? FADE_SCALE / 2 : -FADE_SCALE / 2)) / FADE_SCALE;
+}
+
+static int fade_same_unit(const RFcommand * a, const RFcommand * b)
+{
+	return a->address == b->address && a->unit == b->unit && a->protocol == b->protocol;
+}
+
+/*
+ * @brief reserve a slot for a fade of the unit of command, returns the slot number to put in the command or 0 when all are in use
+ */
+int fadeEngine_prepare(const RFcommand * command, const fadeRequest * request)
+{
+	int i;
+
+	portENTER_CRITICAL(&fadeMux);
+	for(i = 0; i < FADE_MAX_FADES; i++){
+		if(fades[i].state == FADE_FREE){
+			fades[i].state = FADE_RESERVED;
+			//the owner, a command for another unit can not take the slot over
+			fades[i].command = *command;
+			fades[i].from = request->from;
+			fades[i].curve = request->curve;
+			fades[i].duration_ms = request->duration_ms;
+			break;
+		}
+	}
+	portEXIT_CRITICAL(&fadeMux);
+
+	return i < FADE_MAX_FADES ? i + 1 : 0;
+}
+
+/*
+ * @brief give back a reserved slot whose command never made it into the queue
+ */
+void fadeEngine_release(int fade)
+{
+	if(fade < 1 || fade > FADE_MAX_FADES)
+		return;
+	portENTER_CRITICAL(&fadeMux);
+	fades[fade - 1].state = FADE_FREE;
+	portEXIT_CRITICAL(&fadeMux);
+}
+
+/*
+ * @brief free the running fades on the unit of a command, returns how many jobs were put in jobs
+ *
+ * the caller holds fadeMux and finishes the jobs after leaving it
+ */
+static int fade_stop(const RFcommand * command, uint16_t * jobs)
+{
+	int stopped = 0;
+	int i;
+
+	for(i = 0; i < FADE_MAX_FADES; i++){
+		if(fades[i].state == FADE_ACTIVE && fade_same_unit(&fades[i].command, command)){
+			fades[i].state = FADE_FREE;
+			jobs[stopped++] = fades[i].command.job;
+		}
+	}
+	return stopped;
+}
+
+static void fade_finish(const uint16_t * jobs, int stopped)
+{
+	while(stopped--)
+		jobTracker_finish(jobs[stopped], JOB_CANCELLED, xTaskGetTickCount());
+}
+
+/*
+ * @brief stop the fades on the unit of a command, a newer command always wins
+ */
+void fadeEngine_cancel(const RFcommand * command)
+{
+	uint16_t jobs[FADE_MAX_FADES];
+	int stopped;
+
+	portENTER_CRITICAL(&fadeMux);
+	stopped = fade_stop(command, jobs);
+	portEXIT_CRITICAL(&fadeMux);
+
+	fade_finish(jobs, stopped);
+}
+
+/*
+ * @brief activate the fade slot referenced by a dequeued command
+ *
+ * returns 0 when the slot is not reserved for the unit of the command, the caller
+ * then sends the command as a plain one
+ */
+int fadeEngine_start(const RFcommand * command, TickType_t now)
+{
+	uint16_t jobs[FADE_MAX_FADES];
+	int stopped;
+	fade * f;
+	RFcommand step;
+	TickType_t airtime;
+	int levels;
+
+	if(command->fade < 1 || command->fade > FADE_MAX_FADES)
+		return 0;
+
+	//one step never goes faster than it takes on air
+	step = *command;
+	step.fade = 0;
+	step.repetitions = FADE_STEP_REPETITIONS;
+	airtime = frameDispatcher_airtime_us(&step) / 1000 / portTICK_PERIOD_MS + 1;
+
+	f = &fades[command->fade - 1];
+	portENTER_CRITICAL(&fadeMux);
+	if(f->state != FADE_RESERVED || !fade_same_unit(&f->command, command)){
+		portEXIT_CRITICAL(&fadeMux);
+		return 0;
+	}
+	stopped = fade_stop(command, jobs);
+	f->command = *command;
+	f->command.fade = 0;
+	f->last = f->from;
+	f->start = now;
+	f->duration = f->duration_ms / portTICK_PERIOD_MS;
+	if(f->duration == 0)
+		f->duration = 1;
+
+	//one step per level
+	levels = f->command.value > f->from ? f->command.value - f->from : f->from - f->command.value;
+	f->step = levels ? f->duration / levels : f->duration;
+	if(f->step < airtime)
+		f->step = airtime;
+	f->next = now + f->step;
+	f->state = FADE_ACTIVE;
+	portEXIT_CRITICAL(&fadeMux);
+
+	fade_finish(jobs, stopped);
+	return 1;
+}
+
+/*
+ * @brief ticks until the next step of a protocol is due, idle when none of its fades is running
+ */
+TickType_t fadeEngine_wait(int protocol, TickType_t now, TickType_t idle)
+{
+	TickType_t wait = idle;
+	int i;
+
+	for(i = 0; i < FADE_MAX_FADES; i++){
+		if(fades[i].state != FADE_ACTIVE || fades[i].command.protocol != protocol)
+			continue;
+		if((int32_t)(fades[i].next - now) <= 0)
+			return 0;
+		if(fades[i].next - now < wait)
+			wait = fades[i].next - now;
+	}
+	return wait;
+}
+
+/*
+ * @brief produce the next due frame of a fade of the protocol, returns 0 when nothing is due
+ *
+ * when congested only final frames are produced, intermediate steps are dropped
+ */
+int fadeEngine_poll(int protocol, TickType_t now, int congested, RFcommand * step)
+{
+	int i;
+	int level;
+
+	for(i = 0; i < FADE_MAX_FADES; i++){
+		fade * f = &fades[i];
+
+		if(f->state != FADE_ACTIVE || (int32_t)(f->next - now) > 0 || f->command.protocol != protocol)
+			continue;
+
+		if((int32_t)(now - f->start) >= (int32_t)f->duration){
+			*step = f->command;
+			f->state = FADE_FREE;
+			return 1;
+		}
+
+		f->next = now + f->step;
+		level = fade_level(f, now);
+		if(congested || level == f->last)
+			continue;
+
+		*step = f->command;
+		step->value = level;
+		//the job is done with the final level
+		step->job = 0;
+		if(step->repetitions > FADE_STEP_REPETITIONS)
+			step->repetitions = FADE_STEP_REPETITIONS;
+		f->last = level;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * fadeEngine.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_FADEENGINE_H_
+#define MAIN_FADEENGINE_H_
+
+#include "frameDispatcher.h"
+
+#define FADE_MAX_FADES			8		/*!< fades that can run at the same time */
+#define FADE_STEP_REPETITIONS	4		/*!< repetitions of an intermediate step, the final step uses the command's */
+#define FADE_MAX_DURATION_MS	3600000	/*!< longest fade a request may ask for */
+
+enum fadeCurves
+{
+	FADE_LINEAR = 0,
+	FADE_EASE_IN,
+	FADE_EASE_OUT,
+	FADE_EASE
+};
+
+/*
+ * what a client asked for, a slot is only taken when the command is about to be queued
+ */
+typedef struct {
+		int from;
+		uint32_t duration_ms;
+		int curve;
+}fadeRequest;
+
+int fadeEngine_curve(const char * name);
+int fadeEngine_prepare(const RFcommand * command, const fadeRequest * request);
+void fadeEngine_release(int fade);
+int fadeEngine_start(const RFcommand * command, TickType_t now);
+void fadeEngine_cancel(const RFcommand * command);
+TickType_t fadeEngine_wait(int protocol, TickType_t now, TickType_t idle);
+int fadeEngine_poll(int protocol, TickType_t now, int congested, RFcommand * step);
+
+#endif /* MAIN_FADEENGINE_H_ */
@@ -4,8 +4,10 @@
  *      Author: dries
  */
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -15,112 +17,958 @@
 #include "esp_log.h"
 #include "cJSON.h"
 #include "frameDispatcher.h"
-#include "kaku.h"
+#include "rfProtocol.h"
+#include "batchOptimizer.h"
+#include "scheduler.h"
+#include "fadeEngine.h"
+#include "stateCache.h"
+#include "rfRing.h"
+#include "nodeSlab.h"
+#include "jobTracker.h"
+#include "idempotencyCache.h"
+#include "jsonSchema.h"
 
-struct cJSON * json_array;
-struct cJSON * json_array_item;
-int json_array_size;
+typedef struct {
+		const rfProtocol * ops;
+		int protocol;
+		QueueHandle_t queue;		//commands from the scheduler, and from the parser without the ring
+		rfRing ring;				//commands from the parser
+		int use_ring;				//'1' when the ring was allocated, the parser falls back to the queue otherwise
+		TaskHandle_t task;
+		portMUX_TYPE mux;			//guards backlog and rejected, producers and worker run on both cores
+		uint32_t backlog_us;		//air time of the commands waiting in queue and ring
+		TickType_t started;
+		TickType_t busy;			//ticks spent in transmit
+		uint32_t sent;
+		uint32_t rejected;
+		UBaseType_t depth_max;
+}frameDispatcher_worker;
 
-QueueHandle_t commandQueuHandle = 0;
-cJSON * root;
-cJSON * jvalue;
-RFcommand queucommand;
+//one worker per registered protocol, routed to by protocol id
+static frameDispatcher_worker workers[RF_PROTOCOLS];
+static frameDispatcher_worker * workerById[RF_PROTOCOLS];
+static int workerCount = 0;
 
+//rings have a single producer, request handlers on both cores take turns submitting
+static SemaphoreHandle_t submitLock = NULL;
 static const char* JSON_TAG = "JSON";
 
-int frameDispatcher_json_to_queu(char * json){
+static const char * const typeNames[RF_TYPE_UNKNOWN] = { "dimmer", "switch" };
 
-	//try to parse json file
-    if((root = cJSON_Parse((const char *)json)) == NULL){
-    	if(cJSON_GetErrorPtr() != NULL	)
-    		ESP_LOGI(JSON_TAG,"error at: %s",cJSON_GetErrorPtr()-5);
-    		ESP_LOGI(JSON_TAG,"               ^");
+//schedule and policy fields, allowed on the request and on each command
+typedef struct {
+		const cJSON * delay;
+		const cJSON * at;
+		const cJSON * interval;
+		const cJSON * suppress;
+		const cJSON * fresh;
+}frameDispatcher_timing;
+
+//members of a command, filled in one walk of the object by commandSchema
+typedef struct {
+		const char * protocol;
+		const char * type;
+		int value;
+		int unit;
+		int address;
+		int repeat;
+		int group;
+		int ordered;
+		frameDispatcher_timing timing;
+		const cJSON * fade;
+}frameDispatcher_fields;
+
+static const jsonSchemaField commandFields[] = {
+		{ "protocol",	JSONSCHEMA_STRING,	1, offsetof(frameDispatcher_fields, protocol),			0 },
+		{ "type",		JSONSCHEMA_STRING,	0, offsetof(frameDispatcher_fields, type),				0 },
+		{ "value",		JSONSCHEMA_INT,		1, offsetof(frameDispatcher_fields, value),				0 },
+		{ "unit",		JSONSCHEMA_INT,		1, offsetof(frameDispatcher_fields, unit),				0 },
+		{ "address",	JSONSCHEMA_INT,		1, offsetof(frameDispatcher_fields, address),			0 },
+		{ "repeat",		JSONSCHEMA_INT,		0, offsetof(frameDispatcher_fields, repeat),			25 },
+		{ "group",		JSONSCHEMA_BOOL,	0, offsetof(frameDispatcher_fields, group),				0 },
+		{ "ordered",	JSONSCHEMA_BOOL,	0, offsetof(frameDispatcher_fields, ordered),			0 },
+		{ "delay",		JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_fields, timing.delay),		0 },
+		{ "at",			JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_fields, timing.at),			0 },
+		{ "interval",	JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_fields, timing.interval),	0 },
+		{ "suppress",	JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_fields, timing.suppress),	0 },
+		{ "fresh",		JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_fields, timing.fresh),		0 },
+		{ "fade",		JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_fields, fade),				0 }
+};
+
+static const jsonSchemaField requestFields[] = {
+		{ "delay",		JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_timing, delay),		0 },
+		{ "at",			JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_timing, at),		0 },
+		{ "interval",	JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_timing, interval),	0 },
+		{ "suppress",	JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_timing, suppress),	0 },
+		{ "fresh",		JSONSCHEMA_ANY,		0, offsetof(frameDispatcher_timing, fresh),		0 }
+};
+
+//compiled once by the dispatcher task
+static jsonSchema commandSchema;
+static jsonSchema requestSchema;
+static int schemasCompiled = 0;			//requests that need the tree are refused without them
+
+//members of a request that are read, cJSON only checks the syntax of the others
+static const char * const requestKeys[] = { "commands", "cancel", "optimize", "wait", "async", "key",
+		"delay", "at", "interval", "suppress", "fresh", NULL };
+
+/*
+ * @brief device type id by name, RF_TYPE_UNKNOWN when there is no such type
+ */
+int frameDispatcher_type_id(const char * name)
+{
+	int i;
+
+	for(i = 0; name != NULL && i < RF_TYPE_UNKNOWN; i++){
+		if(strcmp(name, typeNames[i]) == 0)
+			return i;
+	}
+	return RF_TYPE_UNKNOWN;
+}
+
+/*
+ * @brief air time of a command in us according to the timing model of its protocol
+ */
+uint32_t frameDispatcher_airtime_us(const RFcommand * command)
+{
+	const rfProtocol * ops = rfProtocol_get(command->protocol);
+
+	return ops ? ops->airtime_us(command) : 0;
+}
+
+/*
+ * @brief worker that transmits the protocol of a command, NULL when no worker handles it
+ */
+static frameDispatcher_worker * frameDispatcher_route(const RFcommand * command)
+{
+	return command->protocol < RF_PROTOCOLS ? workerById[command->protocol] : NULL;
+}
+
+/*
+ * @brief commands waiting at a worker
+ */
+static UBaseType_t frameDispatcher_pending(frameDispatcher_worker * worker)
+{
+	return uxQueueMessagesWaiting(worker->queue) + rfRing_count(&worker->ring);
+}
+
+static void frameDispatcher_track_depth(frameDispatcher_worker * worker)
+{
+	UBaseType_t depth = frameDispatcher_pending(worker);
+
+	if(depth > worker->depth_max)
+		worker->depth_max = depth;
+}
+
+/*
+ * @brief account air time that was handed to (positive) or taken from (negative) a worker
+ */
+static void frameDispatcher_backlog(frameDispatcher_worker * worker, int32_t airtime_us)
+{
+	portENTER_CRITICAL(&worker->mux);
+	if(airtime_us < 0 && (uint32_t)-airtime_us > worker->backlog_us)
+		worker->backlog_us = 0;
+	else
+		worker->backlog_us += airtime_us;
+	portEXIT_CRITICAL(&worker->mux);
+}
+
+/*
+ * @brief count commands that found no room, the scheduler and the request handlers both do
+ */
+static void frameDispatcher_rejected(frameDispatcher_worker * worker, uint32_t commands)
+{
+	portENTER_CRITICAL(&worker->mux);
+	worker->rejected += commands;
+	portEXIT_CRITICAL(&worker->mux);
+}
+
+static uint32_t frameDispatcher_backlog_us(frameDispatcher_worker * worker)
+{
+	uint32_t backlog_us;
+
+	portENTER_CRITICAL(&worker->mux);
+	backlog_us = worker->backlog_us;
+	portEXIT_CRITICAL(&worker->mux);
+	return backlog_us;
+}
+
+/*
+ * @brief queue a command at the worker of its protocol, safe from any task
+ *
+ * returns 0 when no worker handles the protocol or its queue stayed full for wait ticks
+ */
+int frameDispatcher_enqueue(const RFcommand * command, TickType_t wait)
+{
+	frameDispatcher_worker * worker = frameDispatcher_route(command);
+
+	if(worker == NULL)
+		return 0;
+	if(xQueueGenericSend(worker->queue, command, wait, queueSEND_TO_BACK) != pdTRUE){
+		frameDispatcher_rejected(worker, 1);
+		return 0;
+	}
+	frameDispatcher_backlog(worker, frameDispatcher_airtime_us(command));
+	stateCache_record(command, xTaskGetTickCount());
+	//with a ring the worker sleeps on its notification, not on the queue
+	if(worker->use_ring && worker->task != NULL)
+		xTaskNotifyGive(worker->task);
+	frameDispatcher_track_depth(worker);
+	return 1;
+}
+
+/*
+ * @brief queue depth and utilization counters of a worker, returns 0 past the last worker
+ */
+int frameDispatcher_worker_stats(int worker, frameDispatcher_workerStats * stats)
+{
+	frameDispatcher_worker * w;
+	TickType_t elapsed;
+
+	if(worker < 0 || worker >= workerCount)
+		return 0;
+
+	w = &workers[worker];
+	elapsed = xTaskGetTickCount() - w->started;
+	stats->protocol = w->ops->name;
+	stats->depth = frameDispatcher_pending(w);
+	stats->depth_max = w->depth_max;
+	stats->capacity = w->ops->depth + (w->use_ring ? w->ring.mask + 1 : 0);
+	stats->sent = w->sent;
+	portENTER_CRITICAL(&w->mux);
+	stats->rejected = w->rejected;
+	portEXIT_CRITICAL(&w->mux);
+	stats->utilization = elapsed ? (uint32_t)((uint64_t)w->busy * 100 / elapsed) : 0;
+	stats->wakeups = w->ring.wakeups;
+	stats->backlog_ms = frameDispatcher_backlog_us(w) / 1000;
+	return 1;
+}
+
+/*
+ * @brief read the delay, at and interval fields into the entry
+ *
+ * "delay" and "interval" are in ms, "at" is an absolute time in seconds on the
+ * system clock and overrides "delay"
+ */
+static void frameDispatcher_json_to_schedule(const frameDispatcher_timing * timing, batchEntry * entry)
+{
+	const cJSON * jvalue;
+
+	if((jvalue = timing->delay) != NULL && jvalue->valueint > 0){
+		entry->delay_ms = jvalue->valueint;
+	}
+
+	if((jvalue = timing->at) != NULL){
+		time_t now = time(NULL);
+		entry->delay_ms = (jvalue->valuedouble > now) ? (uint32_t)((jvalue->valuedouble - now) * 1000) : 1;
+	}
+
+	if((jvalue = timing->interval) != NULL && jvalue->valueint > 0){
+		entry->interval_ms = jvalue->valueint;
+	}
+}
+
+/*
+ * @brief read the state cache policy, "suppress" is send, skip or shorten and "fresh" the window in ms
+ */
+static void frameDispatcher_json_to_policy(const frameDispatcher_timing * timing, batchEntry * entry)
+{
+	const cJSON * jvalue;
+
+	if((jvalue = timing->suppress) != NULL && cJSON_IsString(jvalue)){
+		entry->policy = stateCache_policy(jvalue->valuestring);
+	}
+
+	if((jvalue = timing->fresh) != NULL && jvalue->valueint > 0){
+		entry->fresh_ms = jvalue->valueint;
+	}
+}
+
+/*
+ * @brief cancel the schedule ids listed in "cancel", a single id or an array
+ */
+static void frameDispatcher_json_cancel(cJSON * cancel, frameDispatcher_result * result)
+{
+	cJSON * id;
+
+	if(cJSON_IsNumber(cancel)){
+		result->cancelled += scheduler_cancel(cancel->valueint);
+		return;
+	}
+	cJSON_ArrayForEach(id, cancel){
+		result->cancelled += scheduler_cancel(id->valueint);
+	}
+}
+
+/*
+ * @brief let the protocol of a parsed command check it, returns -1 with the reason in result when it cannot be sent
+ */
+static int frameDispatcher_validate(const batchEntry * entry, frameDispatcher_result * result)
+{
+	const rfProtocol * ops = rfProtocol_get(entry->command.protocol);
+	const char * reason = NULL;
+
+	if(!ops->validate(&entry->command, &reason)){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "%s", reason);
+		return -1;
+	}
+	return 1;
+}
+
+/*
+ * @brief prefix the reason a request is rejected with the command that caused it
+ */
+static void frameDispatcher_reject(int index, frameDispatcher_result * result)
+{
+	//leaves room for the longest prefix, a long reason is cut short instead of the result
+	char reason[FRAMEDISPATCHER_ERROR_SIZE - sizeof("command -2147483648: ") + 1];
+
+	memcpy(reason, result->error, sizeof(reason) - 1);
+	reason[sizeof(reason) - 1] = 0;
+	snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "command %d: %s", index, reason);
+	ESP_LOGI(JSON_TAG,"%s",result->error);
+}
+
+/*
+ * @brief count a command that is left out because it lacks a field, the first one is reported
+ */
+static void frameDispatcher_skip(int index, const char * field, frameDispatcher_result * result)
+{
+	ESP_LOGI(JSON_TAG,"command %d skipped, no \"%s\"",index,field);
+	if(result->skipped++ == 0){
+		result->skipped_index = index;
+		result->skipped_field = field;
+	}
+}
+
+/*
+ * @brief read "fade", from "from", or the last known value of the unit, to value in "duration" ms
+ *
+ * returns -1 with the reason in result when a field has the wrong type or is out of range
+ */
+static int frameDispatcher_json_to_fade(const cJSON * fade, batchEntry * entry, frameDispatcher_result * result)
+{
+	const rfProtocol * ops = rfProtocol_get(entry->command.protocol);
+	const cJSON * from = cJSON_GetObjectItem(fade, "from");
+	const cJSON * duration = cJSON_GetObjectItem(fade, "duration");
+	const cJSON * curve = cJSON_GetObjectItem(fade, "curve");
+	const char * reason = NULL;
+	RFcommand level = entry->command;
+	TickType_t commanded;
+
+	if(!cJSON_IsObject(fade) || (from != NULL && !cJSON_IsNumber(from)) || (duration != NULL && !cJSON_IsNumber(duration))
+			|| (curve != NULL && !cJSON_IsString(curve))){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "\"fade\" has the wrong type");
+		return -1;
+	}
+	if(duration != NULL && (duration->valueint < 0 || duration->valueint > FADE_MAX_DURATION_MS)){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "fade \"duration\" must be 0..%d ms", FADE_MAX_DURATION_MS);
+		return -1;
+	}
+	//"from" has to be a level the protocol can send, like value
+	if(from != NULL){
+		level.value = from->valueint < 0 ? 0 : (from->valueint > UINT8_MAX ? UINT8_MAX : from->valueint);
+		if(level.value != from->valueint || !ops->validate(&level, &reason)){
+			snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "fade \"from\": %s", reason ? reason : "out of range");
+			return -1;
+		}
+		entry->fade.from = from->valueint;
+	}else if(!stateCache_lookup(&entry->command, &entry->fade.from, &commanded)){
+		entry->fade.from = 0;
+	}
+	entry->fade.duration_ms = duration ? duration->valueint : 0;
+	entry->fade.curve = fadeEngine_curve(curve ? curve->valuestring : NULL);
+	//marks the command as a fade until a slot is reserved
+	entry->command.fade = 1;
+	return 1;
+}
+
+/*
+ * @brief parse one element of the commands array
+ *
+ * returns 1 for a valid command, 0 when the command is incomplete with the field
+ * it lacks in missing, and -1 with the reason in result when the request has to
+ * be rejected
+ */
+static int frameDispatcher_json_to_entry(cJSON * subitem, const batchEntry * defaults, batchEntry * entry, const char ** missing, frameDispatcher_result * result)
+{
+	frameDispatcher_fields fields;
+	const char * key;
+	int status;
+
+	*entry = *defaults;
+
+	if((status = jsonSchema_extract(&commandSchema, subitem, &fields, &key)) == JSONSCHEMA_TYPE){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "\"%s\" has the wrong type", key);
+		return -1;
+	}
+
+	//protocol, an unknown one rejects the request even when the command is incomplete
+	if(fields.protocol != NULL && (entry->command.protocol = rfProtocol_id(fields.protocol)) == RF_PROTOCOL_UNKNOWN){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "unknown protocol \"%s\"", fields.protocol);
+		return -1;
+	}
+	if(status == JSONSCHEMA_MISSING){
+		*missing = key;
+		return 0;
+	}
+
+	entry->command.type = fields.type ? frameDispatcher_type_id(fields.type) : RF_TYPE_DIMMER;
+	entry->command.value = fields.value < 0 ? 0 : (fields.value > UINT8_MAX ? UINT8_MAX : fields.value);
+	entry->command.unit = fields.unit;
+	entry->command.address = fields.address;
+	entry->command.repetitions = fields.repeat < 0 ? 0 : (fields.repeat > UINT8_MAX ? UINT8_MAX : fields.repeat);
+	entry->command.group = fields.group;
+	//ordering constraint for the optimizer
+	entry->ordered = fields.ordered;
+
+	frameDispatcher_json_to_schedule(&fields.timing, entry);
+	frameDispatcher_json_to_policy(&fields.timing, entry);
+
+	if(fields.fade != NULL && frameDispatcher_json_to_fade(fields.fade, entry, result) < 0)
+		return -1;
+
+	return frameDispatcher_validate(entry, result);
+}
+
+/*
+ * @brief reserve the fade of an entry, a fade is a sequence of frames that the optimizer leaves where it is
+ */
+static void frameDispatcher_prepare_fade(batchEntry * entry)
+{
+	if(!entry->command.fade)
+		return;
+
+	entry->ordered = 1;
+	entry->command.fade = fadeEngine_prepare(&entry->command, &entry->fade);
+	if(entry->command.fade == 0)
+		ESP_LOGI(JSON_TAG,"no free fade, sending value directly");
+}
+
+/*
+ * @brief the command of the batch that is queued last before entry i and sets its unit, NULL when there is none
+ */
+static const RFcommand * frameDispatcher_before(const batchEntry * batch, int i)
+{
+	const RFcommand * command = &batch[i].command;
+
+	while(--i >= 0){
+		if(batch[i].dropped || batch[i].command.protocol != command->protocol || batch[i].command.address != command->address)
+			continue;
+		//a group command sets every unit of its address
+		if(batch[i].command.group || batch[i].command.unit == command->unit)
+			return &batch[i].command;
+	}
+	return NULL;
+}
+
+/*
+ * @brief hand every command of a request to the workers, or none of them
+ *
+ * space for all commands is reserved before the first one is written, a batch
+ * that does not fit is rejected right away instead of waiting for the workers,
+ * with the time the client should wait in result. A batch that is larger than
+ * a transmitter holds is rejected without busy, it would never fit. The rings
+ * have a single producer, callers hold submitLock. Returns 0 when the batch was
+ * rejected, the reason is in result
+ */
+static int frameDispatcher_submit(batchEntry * batch, int count, frameDispatcher_result * result)
+{
+	uint32_t needed[RF_PROTOCOLS] = { 0 };
+	uint32_t airtime[RF_PROTOCOLS] = { 0 };
+	frameDispatcher_worker * worker;
+	int i;
+
+	for(i = 0; i < count; i++){
+		if(batch[i].dropped)
+			continue;
+		needed[batch[i].command.protocol]++;
+		airtime[batch[i].command.protocol] += frameDispatcher_airtime_us(&batch[i].command);
+	}
+
+	//a batch larger than a transmitter holds never fits, the client must not retry it
+	for(i = 0; i < RF_PROTOCOLS; i++){
+		if(needed[i] == 0)
+			continue;
+		if((worker = workerById[i]) == NULL){
+			snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "no transmitter for protocol %d", i);
+			return 0;
+		}
+		if(needed[i] > (worker->use_ring ? worker->ring.mask + 1 : worker->ops->depth)){
+			snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "%u %s commands, the transmitter holds %u",
+					needed[i], worker->ops->name, worker->use_ring ? worker->ring.mask + 1 : worker->ops->depth);
+			return 0;
+		}
+	}
+
+	//reserve
+	for(i = 0; i < RF_PROTOCOLS; i++){
+		if(needed[i] == 0)
+			continue;
+		worker = workerById[i];
+		//without a ring the scheduler shares the queue, a command it queues in between is counted as rejected below
+		if(worker->use_ring ? !rfRing_reserve(&worker->ring, needed[i]) : uxQueueSpacesAvailable(worker->queue) < needed[i]){
+			frameDispatcher_rejected(worker, needed[i]);
+			result->busy = 1;
+			result->retry_after = frameDispatcher_backlog_us(worker) / 1000000 + 1;
+			snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "transmitter queue full");
+			return 0;
+		}
+	}
+
+	//counted before the worker can take the commands
+	for(i = 0; i < RF_PROTOCOLS; i++){
+		if(needed[i] != 0)
+			frameDispatcher_backlog(workerById[i], airtime[i]);
+	}
+
+	//fill
+	for(i = 0; i < count; i++){
+		if(batch[i].dropped)
+			continue;
+		worker = workerById[batch[i].command.protocol];
+		if(worker->use_ring){
+			rfRing_stage(&worker->ring, &batch[i].command);
+		}else if(xQueueGenericSend(worker->queue, &batch[i].command, 0, queueSEND_TO_BACK) != pdTRUE){
+			//the frame is not coming, its job must not wait for it and it is not reported as queued,
+			//the caller releases the fade of a dropped entry
+			frameDispatcher_backlog(worker, -(int32_t)frameDispatcher_airtime_us(&batch[i].command));
+			frameDispatcher_rejected(worker, 1);
+			jobTracker_dropped(batch[i].command.job, xTaskGetTickCount());
+			batch[i].dropped = 1;
+			continue;
+		}
+		//the next request compares with what is queued, not with what went on air so far
+		stateCache_record(&batch[i].command, xTaskGetTickCount());
+	}
+
+	//publish, one wakeup per worker
+	for(i = 0; i < RF_PROTOCOLS; i++){
+		if(needed[i] == 0)
+			continue;
+		worker = workerById[i];
+		if(worker->use_ring)
+			rfRing_publish(&worker->ring);
+		frameDispatcher_track_depth(worker);
+	}
+	return 1;
+}
+
+/*
+ * @brief optimize, queue and schedule the parsed commands of a request, frees the batch
+ *
+ * the count immediate commands are at the front of the batch of size entries,
+ * the delayed ones at the back
+ */
+static int frameDispatcher_execute(batchEntry * batch, int size, int count, int delayed, int optimize, frameDispatcher_result * result)
+{
+	int i;
+
+    //delayed fades reserve their slot in the scheduler, for every run
+    for (i = 0 ; i < count ; i++)
+    	frameDispatcher_prepare_fade(&batch[i]);
+
+    result->airtime_before_us = batchOptimizer_airtime_us(batch, count);
+    if(optimize){
+    	batchOptimizer_plan(batch, count);
+    	result->optimized = 1;
+    }
+
+    //leave out sends that would not change the state of the unit
+    for (i = 0 ; i < count ; i++)
+    {
+    	if(!batch[i].dropped && !stateCache_apply(&batch[i].command, batch[i].policy, batch[i].fresh_ms, xTaskGetTickCount(),
+    			frameDispatcher_before(batch, i))){
+    		batch[i].dropped = 1;
+    		result->suppressed++;
+    	}
+    }
+    result->airtime_after_us = batchOptimizer_airtime_us(batch, count);
+
+    //the frames report to a job that the client waits for or polls
+    if(result->wait_ms || result->async){
+    	int frames = 0;
+
+    	for (i = 0 ; i < count ; i++)
+    		frames += !batch[i].dropped;
+    	if(frames)
+    		result->job = jobTracker_create(frames, result->wait_ms ? xTaskGetCurrentTaskHandle() : NULL, xTaskGetTickCount());
+    	for (i = 0 ; i < count ; i++)
+    		batch[i].command.job = result->job;
+    }
+
+    //a scene is applied as a whole, when it does not fit nothing of the request is sent
+    xSemaphoreTake(submitLock, portMAX_DELAY);
+    i = frameDispatcher_submit(batch, count, result);
+    xSemaphoreGive(submitLock);
+    if(!i){
+    	jobTracker_release(result->job);
+    	result->job = 0;
+    	for (i = 0 ; i < count ; i++)
+    		fadeEngine_release(batch[i].command.fade);
+    	ESP_LOGI(JSON_TAG,"%s, %d commands rejected",result->error,count);
+    	free(batch);
     	return -1;
     }
+    for (i = 0 ; i < count ; i++)
+    {
+    	if(!batch[i].dropped)
+    		result->queued++;
+    	else
+    		fadeEngine_release(batch[i].command.fade);
+    }
+
+    //delayed and recurring commands go to the scheduler, in request order
+    for (i = size - 1 ; i >= size - delayed ; i--)
+    {
+    	int id = scheduler_add(&batch[i].command, batch[i].delay_ms, batch[i].interval_ms, &batch[i].fade);
+    	if(id >= 0 && result->scheduled < FRAMEDISPATCHER_REPORT_IDS)
+    		result->schedule_ids[result->scheduled] = id;
+    	if(id >= 0)
+    		result->scheduled++;
+    }
+    free(batch);
+
+    if(result->optimized)
+    	ESP_LOGI(JSON_TAG,"optimized %d commands into %d frames, air time %u us -> %u us",
+    			count, result->queued, result->airtime_before_us, result->airtime_after_us);
+
+    return result->parsed;
+}
+
+/*
+ * @brief queue, schedule or cancel the commands of a parsed request
+ */
+static int frameDispatcher_request(cJSON * root, frameDispatcher_result * result){
+
+	batchEntry * batch;
+	batchEntry defaults;
+	frameDispatcher_timing timing;
+	const char * missing;
+	cJSON * jvalue;
+
+    if((jvalue = cJSON_GetObjectItem(root,"cancel")) != NULL){
+    	frameDispatcher_json_cancel(jvalue, result);
+    }
 
     cJSON *item = cJSON_GetObjectItem(root,"commands");
     if(item == NULL){
+    	if(cJSON_HasObjectItem(root,"cancel"))
+    		return 0;
     	ESP_LOGI(JSON_TAG,"tag \"commands\" not found");
     	return(-1);
     }
 
+    //schedule fields on the request apply to every command
+    memset(&defaults, 0, sizeof(batchEntry));
+    defaults.fresh_ms = STATECACHE_FRESH_MS;
+    jsonSchema_extract(&requestSchema, root, &timing, &missing);
+    frameDispatcher_json_to_schedule(&timing, &defaults);
+    frameDispatcher_json_to_policy(&timing, &defaults);
+
+    //"wait": true or a timeout in ms, the client is answered once the commands went on air
+    if((jvalue = cJSON_GetObjectItem(root, "wait")) != NULL){
+    	if(cJSON_IsTrue(jvalue))
+    		result->wait_ms = JOBTRACKER_WAIT_MS;
+    	else if(cJSON_IsNumber(jvalue) && jvalue->valueint > 0)
+    		result->wait_ms = jvalue->valueint;
+    }
+
+    //"async": true, the client gets the job id right away and polls it, it never also waits
+    if((jvalue = cJSON_GetObjectItem(root, "async")) != NULL)
+    	result->async = cJSON_IsTrue(jvalue);
+    if(result->async)
+    	result->wait_ms = 0;
+
+    result->parsed = cJSON_GetArraySize(item);
+    if(result->parsed == 0)
+    	return 0;
+
+    if((batch = (batchEntry *) malloc(result->parsed * sizeof(batchEntry))) == NULL){
+    	ESP_LOGI(JSON_TAG,"no memory for %d commands",result->parsed);
+    	return(-1);
+    }
+
 	int i;
-    for (i = 0 ; i < cJSON_GetArraySize(item) ; i++)
-    {
-    	cJSON * subitem = cJSON_GetArrayItem(item, i);
+	int count;
+	int delayed;
+	batchEntry entry;
+	cJSON * command;
 
-    	//protocol
-    	if((jvalue = cJSON_GetObjectItem(subitem, "protocol")) != NULL){
-    		strncpy(queucommand.protocol, jvalue->valuestring,RFCOMMAND_STRING_SIZE);
-    	}else{
-    		continue;
+	//immediate commands fill the batch from the front, delayed and recurring ones from the back,
+	//one walk of the list as indexing it per command made a batch quadratic
+	i = 0;
+	count = 0;
+	delayed = 0;
+    cJSON_ArrayForEach(command, item)
+    {
+    	switch(frameDispatcher_json_to_entry(command, &defaults, &entry, &missing, result)){
+    	case 1:
+    		if(entry.delay_ms || entry.interval_ms)
+    			batch[result->parsed - 1 - delayed++] = entry;
+    		else
+    			batch[count++] = entry;
+    		break;
+    	case -1:
+    		//nothing is queued or scheduled from a request with an invalid command
+    		frameDispatcher_reject(i, result);
+    		free(batch);
+    		return -1;
+    	default:
+    		frameDispatcher_skip(i, missing, result);
+    		break;
     	}
+    	i++;
+    }
 
-    	//type
-    	if((jvalue = cJSON_GetObjectItem(subitem, "type")) != NULL){
-    		strncpy(queucommand.type, jvalue->valuestring,RFCOMMAND_STRING_SIZE);
-    	}else{
-    		strncpy(queucommand.type, "dimmer",RFCOMMAND_STRING_SIZE);
-    	}
+    return frameDispatcher_execute(batch, result->parsed, count, delayed,
+    		(jvalue = cJSON_GetObjectItem(root, "optimize")) != NULL && cJSON_IsTrue(jvalue), result);
+}
 
-    	//value
-    	if((jvalue = cJSON_GetObjectItem(subitem, "value")) != NULL){
-    		queucommand.value = jvalue->valueint;
-    	}else{
-    		continue;
-    	}
+/*
+ * @brief handle a request once per "key", a resent copy gets the result of the original
+ */
+static int frameDispatcher_keyed_request(cJSON * root, frameDispatcher_result * result)
+{
+	cJSON * key = cJSON_GetObjectItem(root, "key");
+	int parsed;
 
-    	//value
-		if((jvalue = cJSON_GetObjectItem(subitem, "unit")) != NULL){
-			queucommand.unit = jvalue->valueint;
-		}else{
-			continue;
-		}
+	if(key == NULL || !cJSON_IsString(key))
+		return frameDispatcher_request(root, result);
 
-    	//address
-    	if((jvalue = cJSON_GetObjectItem(subitem, "address")) != NULL){
-    		queucommand.address = jvalue->valueint;
-    	}else{
-    		continue;
-    	}
+	switch(idempotencyCache_claim(key->valuestring, xTaskGetTickCount(), result, &parsed)){
+	case IDEMPOTENCY_DUPLICATE:
+		ESP_LOGI(JSON_TAG,"duplicate of request \"%s\"",key->valuestring);
+		//answered like the original, an async one with the same job id, without waiting again
+		result->duplicate = 1;
+		result->wait_ms = 0;
+		return parsed;
+	case IDEMPOTENCY_PENDING:
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "request \"%s\" is being handled", key->valuestring);
+		result->busy = 1;
+		result->retry_after = 1;
+		return -1;
+	default:
+		break;
+	}
 
-    	//value
-    	if((jvalue = cJSON_GetObjectItem(subitem, "repeat")) != NULL){
-    		queucommand.repetitions = jvalue->valueint;
-    	}else{
-    		queucommand.repetitions = 25;
-    	}
+	parsed = frameDispatcher_request(root, result);
+
+	//requests that were turned away may be retried with the same key
+	if(parsed >= 0)
+		idempotencyCache_store(key->valuestring, result, parsed);
+	else
+		idempotencyCache_release(key->valuestring);
+	return parsed;
+}
+
+/*
+ * @brief check a command read by the streaming reader like the cJSON path does
+ *
+ * a command that lacks the required field missing is counted as skipped and 0
+ * is returned, entry is only read when missing is NULL. Returns -1 when the
+ * command rejects the request
+ */
+int frameDispatcher_check(const batchEntry * entry, const char * protocol, const char * missing, int index, frameDispatcher_result * result)
+{
+	if(missing != NULL){
+		frameDispatcher_skip(index, missing, result);
+		return 0;
+	}
+	if(entry->command.protocol == RF_PROTOCOL_UNKNOWN){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "unknown protocol \"%s\"", protocol);
+		frameDispatcher_reject(index, result);
+		return -1;
+	}
+	if(frameDispatcher_validate(entry, result) < 0){
+		frameDispatcher_reject(index, result);
+		return -1;
+	}
+	return 1;
+}
+
+/*
+ * @brief queue the commands the streaming reader collected, the batch is freed here
+ */
+int frameDispatcher_batch_to_queu(batchEntry * batch, int count, int optimize, frameDispatcher_result * result)
+{
+	return frameDispatcher_execute(batch, count, count, 0, optimize, result);
+}
+
+/*
+ * @brief parse a request into a cJSON tree and queue its commands
+ *
+ * json does not have to be NUL terminated, no byte past json + length is read
+ * so the request can be parsed where the network stack left it. The strings of
+ * the tree are unescaped inside json, which is overwritten
+ */
+int frameDispatcher_tree_to_queu(char * json, size_t length, frameDispatcher_result * result){
+
+	cJSON * root;
+	const char * end = NULL;
+	int parsed;
 
-    	//printf("queued: protocol %s value:%2i addr:%i type %s\n",queucommand.protocol,queucommand.value, queucommand.address,queucommand.type);
+	memset(result, 0, sizeof(frameDispatcher_result));
 
-    	xQueueGenericSend(commandQueuHandle, &queucommand, 1000, queueSEND_TO_BACK);
+	if(!schemasCompiled){
+		snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "request schema not available");
+		return -1;
+	}
+
+	//try to parse json file, the error position is kept per call instead of in cJSON's global
+	//metadata the client sends along is skipped without building a tree for it
+#if FRAMEDISPATCHER_IN_SITU
+    root = cJSON_ParseInSituFilteredOpts(json, length, requestKeys, &end, 0);
+#else
+    root = cJSON_ParseFilteredOpts(json, length, requestKeys, &end, 0);
+#endif
+    if(root == NULL){
+    	if(end != NULL)
+    		ESP_LOGI(JSON_TAG,"error at byte %u",(unsigned)(end - json));
+    	return -1;
     }
 
-    return cJSON_GetArraySize(item);
+    parsed = frameDispatcher_keyed_request(root, result);
+
+    //returns the nodes to the slab, with an arena the strings go when the request is done
+    cJSON_Delete(root);
+
+    return parsed;
 }
 
-void frameDispatcher_task()
+/*
+ * @brief send a command with the transmitter of the worker
+ */
+static void frameDispatcher_transmit(frameDispatcher_worker * worker, RFcommand * command)
+{
+	TickType_t start = xTaskGetTickCount();
+	TickType_t end;
+	int repetitions;
+
+	repetitions = worker->ops->transmit(*command);
+	end = xTaskGetTickCount();
+	stateCache_sent(command, repetitions > 0, end);
+	if(command->job)
+		jobTracker_sent(command->job, repetitions, end - start, end);
+	worker->busy += end - start;
+	worker->sent++;
+}
+
+/*
+ * @brief next command for a worker, waits at most wait ticks for one to arrive
+ */
+static int frameDispatcher_receive(frameDispatcher_worker * worker, RFcommand * command, TickType_t wait)
 {
+	int received;
+
+	if(worker->use_ring){
+		//parsed commands first, then the ones the scheduler queued
+		received = rfRing_pop(&worker->ring, command) || xQueueGenericReceive(worker->queue, command, 0, false);
+		if(!received){
+			ulTaskNotifyTake(pdTRUE, wait);
+			received = rfRing_pop(&worker->ring, command) || xQueueGenericReceive(worker->queue, command, 0, false);
+		}
+	}else{
+		received = xQueueGenericReceive(worker->queue, command, wait, false);
+	}
+	if(received){
+		frameDispatcher_backlog(worker, -(int32_t)frameDispatcher_airtime_us(command));
+		if(command->job)
+			jobTracker_started(command->job, xTaskGetTickCount());
+	}
+	return received;
+}
+
+/*
+ * @brief worker task, transmits the commands of one protocol and runs its fades
+ */
+static void frameDispatcher_worker_task(void * parameters)
+{
+	frameDispatcher_worker * worker = (frameDispatcher_worker *) parameters;
+	int protocol = worker->protocol;
 	RFcommand queucommand;
 
-	//set debug for json
-	esp_log_level_set(JSON_TAG, ESP_LOG_INFO);
-	ESP_LOGI(JSON_TAG,"cJSON version:%s",cJSON_Version());
-	//create command queue
-	commandQueuHandle = xQueueCreate( 10, sizeof(queucommand));
+	worker->task = xTaskGetCurrentTaskHandle();
+	rfRing_attach(&worker->ring, worker->task);
 
 	for(;;){
-		if(xQueueGenericReceive(commandQueuHandle,&queucommand, 10000 , false)){
-			//ESP_LOGI(JSON_TAG,"Enqueued item with protocol \"%s\"",queucommand.protocol);
-			if(strcmp(queucommand.protocol , "kaku\0") == 0 )
-			{
-				kaku_sendframe(queucommand);
+		TickType_t wait = fadeEngine_wait(protocol, xTaskGetTickCount(), 10000);
 
+		if(frameDispatcher_receive(worker, &queucommand, wait)){
+			//ESP_LOGI(JSON_TAG,"Enqueued item with protocol %d",queucommand.protocol);
+			if(!fadeEngine_start(&queucommand, xTaskGetTickCount())){
+				fadeEngine_cancel(&queucommand);
+				frameDispatcher_transmit(worker, &queucommand);
 			}
 		}
+
+		//intermediate fade steps give way to queued commands
+		while(fadeEngine_poll(protocol, xTaskGetTickCount(), frameDispatcher_pending(worker) > 0, &queucommand)){
+			frameDispatcher_transmit(worker, &queucommand);
+		}
 		//ESP_LOGI(JSON_TAG,"Nothing to enqueued");
 	}
+}
 
+/*
+ * @brief compile the key tables and create the submit lock, before any request can arrive
+ *
+ * returns 0 when a schema does not compile, requests that need the parse tree are then refused
+ */
+int frameDispatcher_init()
+{
+	submitLock = xSemaphoreCreateMutex();
+	if(!jsonSchema_compile(&commandSchema, commandFields, sizeof(commandFields) / sizeof(commandFields[0]))
+			|| !jsonSchema_compile(&requestSchema, requestFields, sizeof(requestFields) / sizeof(requestFields[0]))){
+		ESP_LOGE(JSON_TAG,"no key table for the request schemas, requests are refused");
+		return 0;
+	}
+	schemasCompiled = 1;
+	return 1;
 }
 
+void frameDispatcher_task()
+{
+	frameDispatcher_workerStats stats;
+	nodeSlab_stats slab;
+	char name[configMAX_TASK_NAME_LEN];
+	int i;
+
+	//set debug for json
+	esp_log_level_set(JSON_TAG, ESP_LOG_INFO);
+	ESP_LOGI(JSON_TAG,"cJSON version:%s",cJSON_Version());
+
+	//create a queue and a worker per registered protocol
+	for(i = RF_PROTOCOL_UNKNOWN + 1; i < RF_PROTOCOLS; i++){
+		const rfProtocol * ops = rfProtocol_get(i);
+		frameDispatcher_worker * worker = &workers[workerCount];
 
+		if(ops == NULL)
+			continue;
+		worker->ops = ops;
+		worker->protocol = i;
+		worker->started = xTaskGetTickCount();
+		worker->queue = xQueueCreate(ops->depth, sizeof(RFcommand));
+		if(FRAMEDISPATCHER_USE_RING && !(worker->use_ring = rfRing_init(&worker->ring, ops->depth)))
+			ESP_LOGE(JSON_TAG,"no memory for the ring of %s, commands go through its queue",ops->name);
+		vPortCPUInitializeMutex(&worker->mux);
+		snprintf(name, sizeof(name), "tx_%s", ops->name);
+		xTaskCreate(frameDispatcher_worker_task, name, ops->stack, worker, ops->priority, NULL);
+		workerById[i] = worker;
+		workerCount++;
+	}
+	//delayed and recurring commands
+	scheduler_init();
+
+	for(;;){
+		vTaskDelay(60000 / portTICK_PERIOD_MS);
+		for(i = 0; frameDispatcher_worker_stats(i, &stats); i++){
+			ESP_LOGI(JSON_TAG,"worker %s: queued %u/%u (max %u) backlog %u ms sent %u rejected %u busy %u%% wakeups %u",
+					stats.protocol, stats.depth, stats.capacity, stats.depth_max, stats.backlog_ms, stats.sent, stats.rejected, stats.utilization, stats.wakeups);
+		}
+		nodeSlab_get_stats(&slab);
+		ESP_LOGI(JSON_TAG,"cJSON nodes: %u/%u in use (max %u) %u allocated %u from the heap",
+				slab.in_use, slab.capacity, slab.peak, slab.allocations, slab.fallbacks);
+	}
+
+}
@@ -8,19 +8,85 @@
 #ifndef MAIN_FRAMEDISPATCHER_H_
 #define MAIN_FRAMEDISPATCHER_H_
 
-#define RFCOMMAND_STRING_SIZE 16
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
 
+#define FRAMEDISPATCHER_REPORT_IDS	8		/*!< schedule ids reported back per request */
+
+#define FRAMEDISPATCHER_ERROR_SIZE	64		/*!< room for the reason a request was rejected */
+#define FRAMEDISPATCHER_IN_SITU	1		/*!< cJSON unescapes the strings inside the request instead of allocating them */
+#define FRAMEDISPATCHER_USE_RING	1		/*!< parser hands commands to the workers through a lock-free ring instead of their queue */
+
+/* protocol and type names are resolved to these ids once, when the command is parsed */
+enum rfProtocols
+{
+	RF_PROTOCOL_UNKNOWN = 0,
+	RF_PROTOCOL_KAKU,
+	RF_PROTOCOLS
+};
+
+enum rfTypes
+{
+	RF_TYPE_DIMMER = 0,
+	RF_TYPE_SWITCH,
+	RF_TYPE_UNKNOWN
+};
+
+/* packed to the real widths of the fields, 12 bytes per queue slot */
 typedef struct {
-		char protocol[RFCOMMAND_STRING_SIZE];
-		char type[RFCOMMAND_STRING_SIZE];
-		int address;
-		int unit;
-		int value;
-		int repetitions;
+		uint32_t address     :26;	//unique address
+		uint32_t unit        :4;	//specific unit [0...15]
+		uint32_t group       :1;	//'1' addresses all units of the address at once
+		uint32_t             :1;
+		uint8_t protocol;			//RF_PROTOCOL_*
+		uint8_t type         :4;	//RF_TYPE_*
+		uint8_t fade         :4;	//fade slot that ramps towards value, 0 for a plain command
+		uint8_t value;
+		uint8_t repetitions;		//0 means the protocol default
+		uint16_t job;				//job that is told when the command went on air, 0 for none
 }RFcommand;
 
+typedef struct {
+		int parsed;					//commands found in the request
+		int queued;					//frames actually queued
+		int optimized;				//'1' when the batch went through the air-time optimizer
+		uint32_t airtime_before_us;	//air time of the batch as requested
+		uint32_t airtime_after_us;	//air time of the queued frames
+		int scheduled;				//commands handed to the scheduler
+		int schedule_ids[FRAMEDISPATCHER_REPORT_IDS];
+		int cancelled;				//scheduled commands cancelled by the request
+		int suppressed;				//commands skipped because the unit already had the value
+		char error[FRAMEDISPATCHER_ERROR_SIZE];	//why the request was rejected
+		int busy;					//rejected because a transmitter has no room, retry later
+		uint32_t retry_after;		//seconds until the transmitter is expected to have room
+		uint16_t job;				//job following the queued frames, 0 when nothing was queued
+		uint32_t wait_ms;			//how long the client waits for the job, 0 to answer right away
+		int async;					//'1' when the client follows the job on GET /jobs
+		int duplicate;				//'1' when the request was resent with a key that was handled before
+		int skipped;				//incomplete commands that were left out
+		int skipped_index;			//first of them and the field it lacks
+		const char * skipped_field;
+}frameDispatcher_result;
+
+typedef struct {
+		const char * protocol;
+		uint32_t depth;				//commands waiting now
+		uint32_t depth_max;			//most commands that were ever waiting
+		uint32_t capacity;
+		uint32_t sent;				//commands transmitted
+		uint32_t rejected;			//enqueues that found the queue full
+		uint32_t utilization;		//% of the time spent transmitting since the worker started
+		uint32_t wakeups;			//times the parser had to wake the worker
+		uint32_t backlog_ms;		//air time of the commands still waiting
+}frameDispatcher_workerStats;
+
 
-int frameDispatcher_json_to_queu(char * json);
+int frameDispatcher_tree_to_queu(char * json, size_t length, frameDispatcher_result * result);
+int frameDispatcher_type_id(const char * name);
+int frameDispatcher_enqueue(const RFcommand * command, TickType_t wait);
+uint32_t frameDispatcher_airtime_us(const RFcommand * command);
+int frameDispatcher_worker_stats(int worker, frameDispatcher_workerStats * stats);
+int frameDispatcher_init();
 void frameDispatcher_task();
 
 
@@ -0,0 +1,139 @@
+/*
+ * idempotencyCache.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Keys of recent requests with the result they got. A client that timed out
+ *  resends its request with the same key, the copy is answered with the original
+ *  result and nothing goes on air twice. Same open addressing as the state
+ *  cache, expired entries are free and a full probe window replaces the oldest.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "idempotencyCache.h"
+
+#define IDEMPOTENCYCACHE_MASK	(IDEMPOTENCYCACHE_ENTRIES - 1)
+
+enum idempotencyStates
+{
+	KEY_FREE = 0,
+	KEY_PENDING,
+	KEY_DONE
+};
+
+typedef struct {
+		uint32_t hash;
+		char key[IDEMPOTENCYCACHE_KEY_SIZE];
+		TickType_t seen;
+		int state;
+		int parsed;
+		frameDispatcher_result result;
+}keyEntry;
+
+static keyEntry keys[IDEMPOTENCYCACHE_ENTRIES];
+static portMUX_TYPE keyMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t idempotencyCache_hash(const char * key)
+{
+	uint32_t hash = 2166136261u;
+
+	while(*key)
+		hash = (hash ^ (uint8_t)*key++) * 16777619u;
+	return hash;
+}
+
+static int idempotencyCache_live(const keyEntry * entry, TickType_t now)
+{
+	return entry->state != KEY_FREE && now - entry->seen < IDEMPOTENCYCACHE_TTL_MS / portTICK_PERIOD_MS;
+}
+
+/*
+ * @brief slot of a key, or of the slot to (re)use for it when find_free is set, -1 if absent
+ */
+static int idempotencyCache_slot(const char * key, uint32_t hash, TickType_t now, int find_free)
+{
+	int oldest = -1;
+	int i;
+
+	for(i = 0; i < IDEMPOTENCYCACHE_PROBE; i++){
+		int slot = (hash + i) & IDEMPOTENCYCACHE_MASK;
+		keyEntry * entry = &keys[slot];
+
+		if(idempotencyCache_live(entry, now) && entry->hash == hash &&
+				strncmp(entry->key, key, IDEMPOTENCYCACHE_KEY_SIZE - 1) == 0)
+			return slot;
+		if(!find_free)
+			continue;
+		if(!idempotencyCache_live(entry, now))
+			return slot;
+		if(oldest < 0 || (int32_t)(entry->seen - keys[oldest].seen) < 0)
+			oldest = slot;
+	}
+	return oldest;
+}
+
+/*
+ * @brief look a request key up, a new key is claimed for the caller
+ *
+ * for a duplicate the original result and return value are copied out
+ */
+int idempotencyCache_claim(const char * key, TickType_t now, frameDispatcher_result * result, int * parsed)
+{
+	uint32_t hash = idempotencyCache_hash(key);
+	keyEntry * entry;
+	int slot;
+	int claim = IDEMPOTENCY_NEW;
+
+	portENTER_CRITICAL(&keyMux);
+	if((slot = idempotencyCache_slot(key, hash, now, 0)) >= 0){
+		entry = &keys[slot];
+		claim = entry->state == KEY_PENDING ? IDEMPOTENCY_PENDING : IDEMPOTENCY_DUPLICATE;
+		if(claim == IDEMPOTENCY_DUPLICATE){
+			*result = entry->result;
+			*parsed = entry->parsed;
+		}
+	}else{
+		entry = &keys[idempotencyCache_slot(key, hash, now, 1)];
+		entry->hash = hash;
+		strncpy(entry->key, key, IDEMPOTENCYCACHE_KEY_SIZE - 1);
+		entry->key[IDEMPOTENCYCACHE_KEY_SIZE - 1] = 0;
+		entry->seen = now;
+		entry->state = KEY_PENDING;
+	}
+	portEXIT_CRITICAL(&keyMux);
+	return claim;
+}
+
+/*
+ * @brief remember the result of a claimed key
+ */
+void idempotencyCache_store(const char * key, const frameDispatcher_result * result, int parsed)
+{
+	uint32_t hash = idempotencyCache_hash(key);
+	int slot;
+
+	portENTER_CRITICAL(&keyMux);
+	if((slot = idempotencyCache_slot(key, hash, xTaskGetTickCount(), 0)) >= 0){
+		keys[slot].result = *result;
+		keys[slot].parsed = parsed;
+		keys[slot].state = KEY_DONE;
+	}
+	portEXIT_CRITICAL(&keyMux);
+}
+
+/*
+ * @brief forget a claimed key, e.g. when its request was turned away and may be retried
+ */
+void idempotencyCache_release(const char * key)
+{
+	uint32_t hash = idempotencyCache_hash(key);
+	int slot;
+
+	portENTER_CRITICAL(&keyMux);
+	if((slot = idempotencyCache_slot(key, hash, xTaskGetTickCount(), 0)) >= 0)
+		keys[slot].state = KEY_FREE;
+	portEXIT_CRITICAL(&keyMux);
+}
@@ -0,0 +1,28 @@
+/*
+ * idempotencyCache.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_IDEMPOTENCYCACHE_H_
+#define MAIN_IDEMPOTENCYCACHE_H_
+
+#include "frameDispatcher.h"
+
+#define IDEMPOTENCYCACHE_ENTRIES	16		/*!< request keys remembered, must be a power of 2 */
+#define IDEMPOTENCYCACHE_PROBE		4		/*!< slots searched before the oldest is replaced */
+#define IDEMPOTENCYCACHE_KEY_SIZE	32		/*!< longer keys are told apart by their hash */
+#define IDEMPOTENCYCACHE_TTL_MS		60000	/*!< time in which a resent request is a duplicate */
+
+enum idempotencyClaims
+{
+	IDEMPOTENCY_NEW = 0,	//first time the key is seen, the caller handles the request
+	IDEMPOTENCY_DUPLICATE,	//handled before, the original result is returned
+	IDEMPOTENCY_PENDING		//the original is still being handled
+};
+
+int idempotencyCache_claim(const char * key, TickType_t now, frameDispatcher_result * result, int * parsed);
+void idempotencyCache_store(const char * key, const frameDispatcher_result * result, int parsed);
+void idempotencyCache_release(const char * key);
+
+#endif /* MAIN_IDEMPOTENCYCACHE_H_ */
@@ -0,0 +1,243 @@
+/*
+ * jobTracker.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Follows the commands of a request through the workers. Records live in a
+ *  ring indexed by the low bits of the job id, so a lookup is a single slot and
+ *  an id whose slot was reused simply is not found anymore. The commands carry
+ *  the id, the workers report every send and the task that created the job is
+ *  notified when the last one is done.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "jobTracker.h"
+
+#define JOBTRACKER_MASK		(JOBTRACKER_JOBS - 1)
+
+static jobTracker_job jobs[JOBTRACKER_JOBS];
+static uint16_t nextId = 1;
+static portMUX_TYPE jobMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char * const stateNames[] = { "free", "queued", "transmitting", "done", "failed", "cancelled" };
+
+static jobTracker_job * jobTracker_slot(uint16_t id)
+{
+	jobTracker_job * job = &jobs[id & JOBTRACKER_MASK];
+
+	return (id != 0 && job->id == id && job->state != JOB_FREE) ? job : NULL;
+}
+
+/*
+ * @brief finish a job, called with jobMux held, returns the task to wake once it is released
+ */
+static TaskHandle_t jobTracker_close(jobTracker_job * job, int state, TickType_t now)
+{
+	job->state = state;
+	job->finished = now;
+	return job->waiter;
+}
+
+/*
+ * @brief new job for a request of commands commands, returns its id
+ */
+uint16_t jobTracker_create(int commands, TaskHandle_t waiter, TickType_t now)
+{
+	jobTracker_job * job;
+	uint16_t id;
+
+	portENTER_CRITICAL(&jobMux);
+	//0 means no job
+	if((id = nextId++) == 0)
+		id = nextId++;
+	job = &jobs[id & JOBTRACKER_MASK];
+	memset(job, 0, sizeof(jobTracker_job));
+	job->id = id;
+	job->state = JOB_QUEUED;
+	job->outstanding = commands;
+	job->queued = now;
+	job->waiter = waiter;
+	portEXIT_CRITICAL(&jobMux);
+	return id;
+}
+
+/*
+ * @brief forget a job whose commands were never handed to the workers
+ */
+void jobTracker_release(uint16_t id)
+{
+	jobTracker_job * job;
+
+	portENTER_CRITICAL(&jobMux);
+	if((job = jobTracker_slot(id)) != NULL)
+		job->state = JOB_FREE;
+	portEXIT_CRITICAL(&jobMux);
+}
+
+/*
+ * @brief a worker took a command of the job
+ */
+void jobTracker_started(uint16_t id, TickType_t now)
+{
+	jobTracker_job * job;
+
+	portENTER_CRITICAL(&jobMux);
+	if((job = jobTracker_slot(id)) != NULL && job->state == JOB_QUEUED){
+		job->state = JOB_TRANSMITTING;
+		job->started = now;
+	}
+	portEXIT_CRITICAL(&jobMux);
+}
+
+/*
+ * @brief a command of the job went on air repetitions times, the job fails when that is 0
+ */
+void jobTracker_sent(uint16_t id, int repetitions, TickType_t airtime, TickType_t now)
+{
+	jobTracker_job * job;
+	TaskHandle_t waiter = NULL;
+
+	portENTER_CRITICAL(&jobMux);
+	if((job = jobTracker_slot(id)) != NULL && job->state < JOB_DONE){
+		job->repetitions += repetitions;
+		job->airtime += airtime;
+		if(repetitions <= 0)
+			waiter = jobTracker_close(job, JOB_FAILED, now);
+		else if(job->outstanding > 0 && --job->outstanding == 0)
+			waiter = jobTracker_close(job, JOB_DONE, now);
+	}
+	portEXIT_CRITICAL(&jobMux);
+
+	if(waiter != NULL)
+		xTaskNotifyGive(waiter);
+}
+
+/*
+ * @brief a command of the job was never handed to a worker, the job fails since it can not complete
+ */
+void jobTracker_dropped(uint16_t id, TickType_t now)
+{
+	jobTracker_job * job;
+	TaskHandle_t waiter = NULL;
+
+	portENTER_CRITICAL(&jobMux);
+	if((job = jobTracker_slot(id)) != NULL && job->state < JOB_DONE){
+		if(job->outstanding > 0)
+			job->outstanding--;
+		waiter = jobTracker_close(job, JOB_FAILED, now);
+	}
+	portEXIT_CRITICAL(&jobMux);
+
+	if(waiter != NULL)
+		xTaskNotifyGive(waiter);
+}
+
+/*
+ * @brief end a job early, e.g. when a newer command stopped one of its fades
+ */
+void jobTracker_finish(uint16_t id, int state, TickType_t now)
+{
+	jobTracker_job * job;
+	TaskHandle_t waiter = NULL;
+
+	portENTER_CRITICAL(&jobMux);
+	if((job = jobTracker_slot(id)) != NULL && job->state < JOB_DONE)
+		waiter = jobTracker_close(job, state, now);
+	portEXIT_CRITICAL(&jobMux);
+
+	if(waiter != NULL)
+		xTaskNotifyGive(waiter);
+}
+
+/*
+ * @brief copy of a job record, returns 0 when the id is unknown or its slot was reused
+ */
+int jobTracker_get(uint16_t id, jobTracker_job * job)
+{
+	jobTracker_job * slot;
+
+	portENTER_CRITICAL(&jobMux);
+	if((slot = jobTracker_slot(id)) != NULL)
+		*job = *slot;
+	portEXIT_CRITICAL(&jobMux);
+	return slot != NULL;
+}
+
+/*
+ * @brief block the creator of a job until it finishes or timeout ticks passed
+ *
+ * returns 0 when the job is unknown, otherwise the record as it is at that time
+ */
+int jobTracker_wait(uint16_t id, TickType_t timeout, jobTracker_job * job)
+{
+	TickType_t start = xTaskGetTickCount();
+	TickType_t elapsed;
+	jobTracker_job * slot;
+	int found;
+
+	while((found = jobTracker_get(id, job)) && job->state < JOB_DONE &&
+			(elapsed = xTaskGetTickCount() - start) < timeout){
+		ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+	}
+
+	//nobody to wake anymore once the waiter gave up
+	portENTER_CRITICAL(&jobMux);
+	if((slot = jobTracker_slot(id)) != NULL)
+		slot->waiter = NULL;
+	portEXIT_CRITICAL(&jobMux);
+	return found;
+}
+
+const char * jobTracker_state_name(int state)
+{
+	return state >= 0 && state < (int)(sizeof(stateNames) / sizeof(stateNames[0])) ? stateNames[state] : "unknown";
+}
+
+/*
+ * @brief records of the jobs in ids as a json array, every known job when count is 0
+ *
+ * times are in ms since boot, ids that are unknown or were reused are reported as such
+ */
+cJSON * jobTracker_to_json(const uint16_t * ids, int count)
+{
+	cJSON * array = cJSON_CreateArray();
+	jobTracker_job job;
+	int i;
+
+	for(i = 0; array != NULL && i < (count ? count : JOBTRACKER_JOBS); i++){
+		cJSON * record;
+		int found;
+
+		if(count){
+			found = jobTracker_get(ids[i], &job);
+		}else{
+			portENTER_CRITICAL(&jobMux);
+			job = jobs[i];
+			portEXIT_CRITICAL(&jobMux);
+			found = job.state != JOB_FREE;
+		}
+		if((!found && !count) || (record = cJSON_CreateObject()) == NULL)
+			continue;
+
+		cJSON_AddNumberToObject(record, "id", count ? ids[i] : job.id);
+		if(!found){
+			cJSON_AddStringToObject(record, "state", "unknown");
+			cJSON_AddItemToArray(array, record);
+			continue;
+		}
+		cJSON_AddStringToObject(record, "state", jobTracker_state_name(job.state));
+		cJSON_AddNumberToObject(record, "queued", job.queued * portTICK_PERIOD_MS);
+		if(job.state > JOB_QUEUED)
+			cJSON_AddNumberToObject(record, "started", job.started * portTICK_PERIOD_MS);
+		if(job.state >= JOB_DONE)
+			cJSON_AddNumberToObject(record, "finished", job.finished * portTICK_PERIOD_MS);
+		cJSON_AddNumberToObject(record, "outstanding", job.outstanding);
+		cJSON_AddNumberToObject(record, "repetitions", job.repetitions);
+		cJSON_AddNumberToObject(record, "airtime", job.airtime * portTICK_PERIOD_MS);
+		cJSON_AddItemToArray(array, record);
+	}
+	return array;
+}
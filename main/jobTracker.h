@@ -0,0 +1,52 @@
+/*
+ * jobTracker.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_JOBTRACKER_H_
+#define MAIN_JOBTRACKER_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "frameDispatcher.h"
+#include "cJSON.h"
+
+#define JOBTRACKER_JOBS			32		/*!< job records kept, a power of 2, the oldest is reused */
+#define JOBTRACKER_WAIT_MS		10000	/*!< default time a client waits for its commands */
+
+enum jobStates
+{
+	JOB_FREE = 0,
+	JOB_QUEUED,			//handed to the workers
+	JOB_TRANSMITTING,	//a worker took the first command
+	JOB_DONE,			//every command went on air
+	JOB_FAILED,			//a command could not be sent
+	JOB_CANCELLED		//a newer command for the unit stopped it
+};
+
+/* the immediate commands of one request */
+typedef struct {
+		uint16_t id;
+		uint8_t state;
+		uint16_t outstanding;		//commands not yet sent
+		TickType_t queued;
+		TickType_t started;			//a worker took the first command
+		TickType_t finished;
+		TickType_t airtime;			//ticks spent transmitting
+		uint32_t repetitions;		//frames that went on air
+		TaskHandle_t waiter;		//notified when the job finishes
+}jobTracker_job;
+
+uint16_t jobTracker_create(int commands, TaskHandle_t waiter, TickType_t now);
+void jobTracker_release(uint16_t id);
+void jobTracker_started(uint16_t id, TickType_t now);
+void jobTracker_sent(uint16_t id, int repetitions, TickType_t airtime, TickType_t now);
+void jobTracker_dropped(uint16_t id, TickType_t now);
+void jobTracker_finish(uint16_t id, int state, TickType_t now);
+int jobTracker_get(uint16_t id, jobTracker_job * job);
+int jobTracker_wait(uint16_t id, TickType_t timeout, jobTracker_job * job);
+const char * jobTracker_state_name(int state);
+cJSON * jobTracker_to_json(const uint16_t * ids, int count);
+
+#endif /* MAIN_JOBTRACKER_H_ */
@@ -0,0 +1,376 @@
+/*
+ * jsonPull.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Byte at a time JSON tokenizer. Every call consumes input until one token is
+ *  complete and returns it, the grammar is checked on the way with a bit stack
+ *  of open containers and the token that may come next. Strings and numbers are
+ *  copied into the fixed text buffer of the state, nothing is allocated and the
+ *  input is only read, so it may be a buffer that is not NUL terminated. \u
+ *  escapes outside the basic multilingual plane come out as '?'.
+ */
+#include <string.h>
+#include "jsonPull.h"
+
+enum jsonPullLexers
+{
+	LEX_SPACE = 0,		//between tokens
+	LEX_STRING,
+	LEX_ESCAPE,			//after a backslash
+	LEX_UNICODE,		//hex digits of a \u escape
+	LEX_NUMBER,
+	LEX_LITERAL
+};
+
+enum jsonPullExpects
+{
+	EXPECT_VALUE = 0,
+	EXPECT_VALUE_OR_END,	//first element of an array
+	EXPECT_KEY,
+	EXPECT_KEY_OR_END,		//first member of an object
+	EXPECT_COLON,
+	EXPECT_COMMA_OR_END,
+	EXPECT_DONE,
+	EXPECT_ERROR			//sticky, the document is broken
+};
+
+enum jsonPullNumberSteps
+{
+	NUM_SIGN = 0,		//after the minus
+	NUM_ZERO,			//leading zero, no more integral digits
+	NUM_INT,
+	NUM_DOT,
+	NUM_FRAC,
+	NUM_EXP,
+	NUM_EXP_SIGN,
+	NUM_EXP_DIGITS
+};
+
+static void jsonPull_append(jsonPull * json, char c)
+{
+	if(json->length < JSONPULL_TEXT_SIZE - 1)
+		json->text[json->length++] = c;
+	else
+		json->truncated = 1;
+}
+
+static void jsonPull_append_utf8(jsonPull * json, uint16_t codepoint)
+{
+	if(codepoint < 0x80){
+		jsonPull_append(json, (char)codepoint);
+	}else if(codepoint < 0x800){
+		jsonPull_append(json, (char)(0xC0 | (codepoint >> 6)));
+		jsonPull_append(json, (char)(0x80 | (codepoint & 0x3F)));
+	}else if(codepoint >= 0xD800 && codepoint <= 0xDFFF){
+		jsonPull_append(json, '?');
+	}else{
+		jsonPull_append(json, (char)(0xE0 | (codepoint >> 12)));
+		jsonPull_append(json, (char)(0x80 | ((codepoint >> 6) & 0x3F)));
+		jsonPull_append(json, (char)(0x80 | (codepoint & 0x3F)));
+	}
+}
+
+static int jsonPull_in_object(const jsonPull * json)
+{
+	return json->depth && ((json->containers >> (json->depth - 1)) & 1);
+}
+
+static int jsonPull_value_expected(const jsonPull * json)
+{
+	return json->expect == EXPECT_VALUE || json->expect == EXPECT_VALUE_OR_END;
+}
+
+static void jsonPull_after_value(jsonPull * json)
+{
+	json->expect = json->depth ? EXPECT_COMMA_OR_END : EXPECT_DONE;
+}
+
+static int jsonPull_push(jsonPull * json, int object)
+{
+	if(!jsonPull_value_expected(json) || json->depth >= JSONPULL_MAX_DEPTH)
+		return JSONPULL_ERROR;
+
+	if(object)
+		json->containers |= (uint32_t)1 << json->depth;
+	else
+		json->containers &= ~((uint32_t)1 << json->depth);
+	json->depth++;
+	json->expect = object ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+	return object ? JSONPULL_OBJECT : JSONPULL_ARRAY;
+}
+
+static int jsonPull_pop(jsonPull * json, int object)
+{
+	if(json->depth == 0 || jsonPull_in_object(json) != object)
+		return JSONPULL_ERROR;
+	if(json->expect != EXPECT_COMMA_OR_END && json->expect != (object ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END))
+		return JSONPULL_ERROR;
+
+	json->depth--;
+	jsonPull_after_value(json);
+	return object ? JSONPULL_OBJECT_END : JSONPULL_ARRAY_END;
+}
+
+static void jsonPull_start_text(jsonPull * json, int lexer)
+{
+	json->lexer = lexer;
+	json->length = 0;
+	json->truncated = 0;
+}
+
+/*
+ * @brief a byte between tokens, returns the token it completes, 0 when none
+ */
+static int jsonPull_structure(jsonPull * json, char c)
+{
+	switch(c){
+	case ' ':
+	case '\t':
+	case '\n':
+	case '\r':
+		return 0;
+	case '{':
+		return jsonPull_push(json, 1);
+	case '[':
+		return jsonPull_push(json, 0);
+	case '}':
+		return jsonPull_pop(json, 1);
+	case ']':
+		return jsonPull_pop(json, 0);
+	case ',':
+		if(json->expect != EXPECT_COMMA_OR_END)
+			return JSONPULL_ERROR;
+		json->expect = jsonPull_in_object(json) ? EXPECT_KEY : EXPECT_VALUE;
+		return 0;
+	case ':':
+		if(json->expect != EXPECT_COLON)
+			return JSONPULL_ERROR;
+		json->expect = EXPECT_VALUE;
+		return 0;
+	case '"':
+		if(json->expect == EXPECT_KEY || json->expect == EXPECT_KEY_OR_END)
+			json->key = 1;
+		else if(jsonPull_value_expected(json))
+			json->key = 0;
+		else
+			return JSONPULL_ERROR;
+		jsonPull_start_text(json, LEX_STRING);
+		return 0;
+	case 't':
+	case 'f':
+	case 'n':
+		if(!jsonPull_value_expected(json))
+			return JSONPULL_ERROR;
+		json->literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+		json->step = 1;
+		json->lexer = LEX_LITERAL;
+		return 0;
+	default:
+		if(c != '-' && (c < '0' || c > '9'))
+			return JSONPULL_ERROR;
+		if(!jsonPull_value_expected(json))
+			return JSONPULL_ERROR;
+		jsonPull_start_text(json, LEX_NUMBER);
+		jsonPull_append(json, c);
+		json->negative = c == '-';
+		json->integer = c == '-' ? 0 : c - '0';
+		json->step = c == '-' ? NUM_SIGN : (c == '0' ? NUM_ZERO : NUM_INT);
+		return 0;
+	}
+}
+
+static int jsonPull_string(jsonPull * json, char c)
+{
+	switch(json->lexer){
+	case LEX_STRING:
+		if(c == '"'){
+			json->text[json->length] = 0;
+			json->lexer = LEX_SPACE;
+			if(json->key){
+				json->expect = EXPECT_COLON;
+				return JSONPULL_KEY;
+			}
+			jsonPull_after_value(json);
+			return JSONPULL_STRING;
+		}
+		if(c == '\\'){
+			json->lexer = LEX_ESCAPE;
+			return 0;
+		}
+		if((unsigned char)c < 0x20)
+			return JSONPULL_ERROR;
+		jsonPull_append(json, c);
+		return 0;
+
+	case LEX_ESCAPE:
+		json->lexer = LEX_STRING;
+		switch(c){
+		case 'b': jsonPull_append(json, '\b'); return 0;
+		case 'f': jsonPull_append(json, '\f'); return 0;
+		case 'n': jsonPull_append(json, '\n'); return 0;
+		case 'r': jsonPull_append(json, '\r'); return 0;
+		case 't': jsonPull_append(json, '\t'); return 0;
+		case '"':
+		case '\\':
+		case '/':
+			jsonPull_append(json, c);
+			return 0;
+		case 'u':
+			json->lexer = LEX_UNICODE;
+			json->step = 0;
+			json->codepoint = 0;
+			return 0;
+		default:
+			return JSONPULL_ERROR;
+		}
+
+	default:
+		if(c >= '0' && c <= '9')
+			json->codepoint = (json->codepoint << 4) | (c - '0');
+		else if(c >= 'a' && c <= 'f')
+			json->codepoint = (json->codepoint << 4) | (c - 'a' + 10);
+		else if(c >= 'A' && c <= 'F')
+			json->codepoint = (json->codepoint << 4) | (c - 'A' + 10);
+		else
+			return JSONPULL_ERROR;
+		if(++json->step == 4){
+			jsonPull_append_utf8(json, json->codepoint);
+			json->lexer = LEX_STRING;
+		}
+		return 0;
+	}
+}
+
+/*
+ * @brief a byte of a number, the byte after the number ends it and is left for the next token
+ */
+static int jsonPull_number(jsonPull * json, char c, int * consumed)
+{
+	if(c >= '0' && c <= '9'){
+		switch(json->step){
+		case NUM_ZERO:
+			return JSONPULL_ERROR;
+		case NUM_SIGN:
+			json->step = c == '0' ? NUM_ZERO : NUM_INT;
+			/* fall through */
+		case NUM_INT:
+			//integral part, saturated to the range of the integer
+			if(json->integer > (INT32_MAX - (c - '0')) / 10)
+				json->integer = INT32_MAX;
+			else
+				json->integer = json->integer * 10 + (c - '0');
+			break;
+		case NUM_DOT:
+			json->step = NUM_FRAC;
+			break;
+		case NUM_EXP:
+		case NUM_EXP_SIGN:
+			json->step = NUM_EXP_DIGITS;
+			break;
+		default:
+			break;
+		}
+		jsonPull_append(json, c);
+		return 0;
+	}
+
+	if(c == '.' && (json->step == NUM_ZERO || json->step == NUM_INT)){
+		json->step = NUM_DOT;
+	}else if((c == 'e' || c == 'E') && (json->step == NUM_ZERO || json->step == NUM_INT || json->step == NUM_FRAC)){
+		json->step = NUM_EXP;
+	}else if((c == '+' || c == '-') && json->step == NUM_EXP){
+		json->step = NUM_EXP_SIGN;
+	}else{
+		if(json->step != NUM_ZERO && json->step != NUM_INT && json->step != NUM_FRAC && json->step != NUM_EXP_DIGITS)
+			return JSONPULL_ERROR;
+		*consumed = 0;
+		json->text[json->length] = 0;
+		if(json->negative)
+			json->integer = -json->integer;
+		json->lexer = LEX_SPACE;
+		jsonPull_after_value(json);
+		return JSONPULL_NUMBER;
+	}
+	jsonPull_append(json, c);
+	return 0;
+}
+
+static int jsonPull_literal(jsonPull * json, char c)
+{
+	if(c != json->literal[json->step])
+		return JSONPULL_ERROR;
+	if(json->literal[++json->step] != 0)
+		return 0;
+
+	json->lexer = LEX_SPACE;
+	jsonPull_after_value(json);
+	return json->literal[0] == 't' ? JSONPULL_TRUE : (json->literal[0] == 'f' ? JSONPULL_FALSE : JSONPULL_NULL);
+}
+
+void jsonPull_init(jsonPull * json)
+{
+	memset(json, 0, sizeof(jsonPull));
+	json->expect = EXPECT_VALUE;
+	json->lexer = LEX_SPACE;
+}
+
+/*
+ * @brief next chunk of the document, the previous one must have been used up
+ */
+void jsonPull_feed(jsonPull * json, const char * data, size_t length)
+{
+	json->input = data;
+	json->left = length;
+}
+
+/*
+ * @brief read up to the next token
+ *
+ * returns JSONPULL_MORE when the chunk ran out first, the token then completes
+ * with the next chunk. Errors are sticky, offset is where the document broke
+ */
+int jsonPull_next(jsonPull * json)
+{
+	int token;
+
+	if(json->expect == EXPECT_ERROR)
+		return JSONPULL_ERROR;
+
+	while(json->left > 0){
+		char c = *json->input;
+		int consumed = 1;
+
+		switch(json->lexer){
+		case LEX_SPACE:
+			//whatever follows the document is not ours
+			if(json->expect == EXPECT_DONE)
+				return JSONPULL_END;
+			token = jsonPull_structure(json, c);
+			break;
+		case LEX_NUMBER:
+			token = jsonPull_number(json, c, &consumed);
+			break;
+		case LEX_LITERAL:
+			token = jsonPull_literal(json, c);
+			break;
+		default:
+			token = jsonPull_string(json, c);
+			break;
+		}
+
+		if(token == JSONPULL_ERROR){
+			json->expect = EXPECT_ERROR;
+			return JSONPULL_ERROR;
+		}
+		if(consumed){
+			json->input++;
+			json->left--;
+			json->offset++;
+		}
+		if(token != 0)
+			return token;
+	}
+
+	return (json->expect == EXPECT_DONE && json->lexer == LEX_SPACE) ? JSONPULL_END : JSONPULL_MORE;
+}
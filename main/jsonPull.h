@@ -0,0 +1,61 @@
+/*
+ * jsonPull.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_JSONPULL_H_
+#define MAIN_JSONPULL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSONPULL_TEXT_SIZE		40		/*!< longest string or number kept, longer ones are truncated */
+#define JSONPULL_MAX_DEPTH		32		/*!< nesting of objects and arrays */
+
+enum jsonPullTokens
+{
+	JSONPULL_MORE = 0,		//the input ran out, feed the next chunk
+	JSONPULL_OBJECT,
+	JSONPULL_OBJECT_END,
+	JSONPULL_ARRAY,
+	JSONPULL_ARRAY_END,
+	JSONPULL_KEY,			//text holds the member name
+	JSONPULL_STRING,		//text holds the unescaped string
+	JSONPULL_NUMBER,		//text holds the number as written, integer its integral part
+	JSONPULL_TRUE,
+	JSONPULL_FALSE,
+	JSONPULL_NULL,
+	JSONPULL_END,			//the top level value is complete
+	JSONPULL_ERROR
+};
+
+/* pull tokenizer that never allocates
+ *
+ * the whole state lives in this struct and input is consumed byte by byte, so
+ * a document can be fed in chunks and a token may span two of them
+ */
+typedef struct {
+		const char * input;			//rest of the current chunk
+		size_t left;
+		size_t offset;				//bytes consumed since init, for error positions
+		uint32_t containers;		//bit per level, set for an object
+		uint8_t depth;
+		uint8_t expect;				//what the grammar allows next
+		uint8_t lexer;				//token being read
+		uint8_t step;				//position inside a number, literal or escape
+		uint8_t key;				//the string being read is a member name
+		uint8_t truncated;			//text did not fit
+		uint8_t length;
+		uint8_t negative;
+		uint16_t codepoint;			//\u escape being read
+		const char * literal;		//true, false or null being matched
+		int32_t integer;
+		char text[JSONPULL_TEXT_SIZE];
+}jsonPull;
+
+void jsonPull_init(jsonPull * json);
+void jsonPull_feed(jsonPull * json, const char * data, size_t length);
+int jsonPull_next(jsonPull * json);
+
+#endif /* MAIN_JSONPULL_H_ */
@@ -0,0 +1,176 @@
+/*
+ * jsonSchema.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Fills a struct from the members of a cJSON object in a single walk of the
+ *  member list, instead of one cJSON_GetObjectItem scan per field. The keys of
+ *  a schema are hashed once into a table without collisions, a member then costs
+ *  one hash of its name and one compare with the only key it can be. Like
+ *  cJSON_GetObjectItem names match case-insensitively and the first of duplicate
+ *  members counts. Keys of a schema are written in lower case.
+ */
+#include <ctype.h>
+#include <string.h>
+#include "jsonSchema.h"
+
+#define FIELD_BIT(field)	((uint32_t)1 << (field))
+
+/*
+ * @brief seeded FNV-1a of the lower cased name
+ */
+static uint32_t jsonSchema_hash(const char * name, uint32_t seed)
+{
+	uint32_t hash = 2166136261u ^ (seed * 16777619u);
+
+	for(; *name; name++){
+		hash ^= (uint8_t)tolower((unsigned char)*name);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/*
+ * @brief true when name is key in any case, key is lower case
+ */
+static int jsonSchema_same(const char * name, const char * key)
+{
+	for(; *key; name++, key++){
+		if(tolower((unsigned char)*name) != *key)
+			return 0;
+	}
+	return *name == 0;
+}
+
+/*
+ * @brief fill the table with the given size and seed, returns 0 when two keys collide
+ */
+static int jsonSchema_place(jsonSchema * schema, uint32_t size, uint32_t seed)
+{
+	uint32_t slot;
+	int i;
+
+	memset(schema->slots, 0, sizeof(schema->slots));
+	schema->mask = size - 1;
+	schema->seed = seed;
+	for(i = 0; i < schema->count; i++){
+		slot = jsonSchema_hash(schema->fields[i].key, seed) & schema->mask;
+		if(schema->slots[slot])
+			return 0;
+		schema->slots[slot] = i + 1;
+	}
+	return 1;
+}
+
+/*
+ * @brief field the member name is, -1 when the schema does not have it
+ */
+static int jsonSchema_find(const jsonSchema * schema, const char * name)
+{
+	int field = schema->slots[jsonSchema_hash(name, schema->seed) & schema->mask] - 1;
+
+	if(field < 0 || !jsonSchema_same(name, schema->fields[field].key))
+		return -1;
+	return field;
+}
+
+/*
+ * @brief write value, or the fallback when it is NULL, returns 0 when the value has the wrong type
+ */
+static int jsonSchema_store(const jsonSchemaField * field, const cJSON * value, void * out)
+{
+	char * destination = (char *)out + field->offset;
+
+	switch(field->type){
+	case JSONSCHEMA_INT:
+		if(value != NULL && !cJSON_IsNumber(value))
+			return 0;
+		*(int *)destination = value ? value->valueint : field->fallback;
+		return 1;
+	case JSONSCHEMA_NUMBER:
+		if(value != NULL && !cJSON_IsNumber(value))
+			return 0;
+		*(cJSON_number *)destination = value ? value->valuedouble : field->fallback;
+		return 1;
+	case JSONSCHEMA_BOOL:
+		if(value != NULL && !cJSON_IsBool(value))
+			return 0;
+		*(int *)destination = value ? cJSON_IsTrue(value) : field->fallback;
+		return 1;
+	case JSONSCHEMA_STRING:
+		if(value != NULL && !cJSON_IsString(value))
+			return 0;
+		*(const char **)destination = value ? value->valuestring : NULL;
+		return 1;
+	default:
+		*(const cJSON **)destination = value;
+		return 1;
+	}
+}
+
+/*
+ * @brief build the key table of a schema, returns 0 when the fields do not fit
+ *
+ * the smallest table that holds every key in its own slot is kept, tables of
+ * at least twice the number of fields are tried first so a seed is found quickly
+ */
+int jsonSchema_compile(jsonSchema * schema, const jsonSchemaField * fields, int count)
+{
+	uint32_t size;
+	uint32_t seed;
+
+	if(count <= 0 || count > JSONSCHEMA_FIELDS)
+		return 0;
+
+	schema->fields = fields;
+	schema->count = count;
+	for(size = 2; size <= JSONSCHEMA_SLOTS; size <<= 1){
+		if(size < (uint32_t)count * 2)
+			continue;
+		for(seed = 0; seed < JSONSCHEMA_SEEDS; seed++){
+			if(jsonSchema_place(schema, size, seed))
+				return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * @brief fill out from the members of object
+ *
+ * absent fields get their fallback, members the schema does not know are left
+ * alone. Returns JSONSCHEMA_TYPE at the first member with a value of the wrong
+ * type and JSONSCHEMA_MISSING when a required field is absent, out is complete
+ * in the latter case. key is set to the field at fault
+ */
+int jsonSchema_extract(const jsonSchema * schema, const cJSON * object, void * out, const char ** key)
+{
+	cJSON * member;
+	uint32_t seen = 0;
+	int field;
+
+	for(field = 0; field < schema->count; field++)
+		jsonSchema_store(&schema->fields[field], NULL, out);
+
+	if(cJSON_IsObject(object)){
+		cJSON_ArrayForEach(member, object){
+			if(member->string == NULL || (field = jsonSchema_find(schema, member->string)) < 0)
+				continue;
+			if(seen & FIELD_BIT(field))
+				continue;
+			seen |= FIELD_BIT(field);
+			if(!jsonSchema_store(&schema->fields[field], member, out)){
+				*key = schema->fields[field].key;
+				return JSONSCHEMA_TYPE;
+			}
+		}
+	}
+
+	for(field = 0; field < schema->count; field++){
+		if(schema->fields[field].required && !(seen & FIELD_BIT(field))){
+			*key = schema->fields[field].key;
+			return JSONSCHEMA_MISSING;
+		}
+	}
+	return JSONSCHEMA_OK;
+}
@@ -0,0 +1,59 @@
+/*
+ * jsonSchema.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_JSONSCHEMA_H_
+#define MAIN_JSONSCHEMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cJSON.h"
+
+#define JSONSCHEMA_FIELDS		32		/*!< most fields in a schema, one bit each while extracting */
+#define JSONSCHEMA_SLOTS		128		/*!< largest key table, must be a power of two */
+#define JSONSCHEMA_SEEDS		1024	/*!< seeds tried per table size when compiling */
+
+enum jsonSchemaTypes
+{
+	JSONSCHEMA_INT = 0,		//int, from a number
+	JSONSCHEMA_NUMBER,		//cJSON_number, from a number
+	JSONSCHEMA_BOOL,		//int, from true or false
+	JSONSCHEMA_STRING,		//const char *, points into the tree
+	JSONSCHEMA_ANY			//const cJSON *, any value, read by the caller
+};
+
+enum jsonSchemaResults
+{
+	JSONSCHEMA_OK = 0,
+	JSONSCHEMA_MISSING,		//a required field is absent
+	JSONSCHEMA_TYPE			//a field has a value of the wrong type
+};
+
+/*
+ * one field of a schema, the value is written at offset in the output struct
+ */
+typedef struct {
+		const char * key;
+		uint8_t type;				//JSONSCHEMA_*
+		uint8_t required;			//'1' when the object is incomplete without it
+		uint16_t offset;			//offsetof the destination
+		int32_t fallback;			//value of an absent int, number or bool
+}jsonSchemaField;
+
+/*
+ * a field table with its perfect hash, keys are matched case-insensitively like cJSON_GetObjectItem
+ */
+typedef struct {
+		const jsonSchemaField * fields;
+		uint8_t count;
+		uint8_t mask;				//table size - 1
+		uint32_t seed;
+		uint8_t slots[JSONSCHEMA_SLOTS];	//field + 1 by hash of the key, 0 for none
+}jsonSchema;
+
+int jsonSchema_compile(jsonSchema * schema, const jsonSchemaField * fields, int count);
+int jsonSchema_extract(const jsonSchema * schema, const cJSON * object, void * out, const char ** key);
+
+#endif /* MAIN_JSONSCHEMA_H_ */
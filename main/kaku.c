@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -24,6 +25,7 @@ static const char* KAKU_TAG = "KAKU";
 #define KAKU_OFF				(x & 0xFFFFFFEFul)
 
 #define KAKU_MINIMAL_MSSG_SIZE  32				/*!< 32  without dim 36 with dim*/
+#define KAKU_FRAME_ITEMS		100				/*!< pulse items allocated for one frame */
 
 #define KAKU_BIT_SHORT_HIGH		221              /*!< KAKU protocol data bit : positive 0.275ms */
 #define KAKU_BIT_SHORT_LOW		321              /*!< KAKU protocol data bit : positive 0.275ms */
@@ -192,42 +194,124 @@ static int kaku_build_frame(rmt_item32_t* item, kaku_frame * frame )
     return (item - start_item)+1;
 }
 
-/**
- * @brief RMT transmitter demo, this task will periodically send NEC data. (100 * 32 bits each time.)
+/*
+ * @brief clamp the repetitions of a command to what the transmitter accepts
+ */
+static int kaku_repetitions(const RFcommand * command)
+{
+	if(command->repetitions > 100)return 100;
+	if(command->repetitions < 1)return 25;
+	return command->repetitions;
+}
+
+/*
+ * @brief air time of one kaku frame in us, derived from the pulse timings above
  *
+ *  ST + 27 address/group bits + state bit + 4 unit bits [+ 4 dim bits] + SP
+ *  a dim frame replaces the state bit by a DIM pulse and is 8 pulses longer
  */
-void kaku_sendframe(RFcommand command)
+static uint32_t kaku_frame_airtime_us(int value)
 {
-	int x;
+	const uint32_t bit_us = 2 * KAKU_BIT_SHORT_HIGH + KAKU_BIT_SHORT_LOW + KAKU_BIT_LONG;
+	uint32_t airtime = (KAKU_START_HIGH + KAKU_START_LOW) + (KAKU_STOP_HIGH + KAKU_STOP_LOW);
+
+	airtime += (27 + 4) * bit_us;
+	if(value % 16 == 0){
+		airtime += bit_us;
+	}else{
+		airtime += 2 * (KAKU_BIT_SHORT_HIGH + KAKU_BIT_SHORT_LOW) + 4 * bit_us;
+	}
+	return airtime;
+}
+
+/*
+ * @brief total air time of a command (all repetitions) in us
+ */
+uint32_t kaku_airtime_us(const RFcommand * command)
+{
+	return kaku_frame_airtime_us(command->value) * kaku_repetitions(command);
+}
+
+/*
+ * @brief reject what a kaku receiver cannot do
+ */
+static int kaku_validate(const RFcommand * command, const char ** reason)
+{
+	if(command->value > 15){
+		*reason = "kaku value must be 0..15";
+		return 0;
+	}
+	if(command->type != RF_TYPE_DIMMER && command->type != RF_TYPE_SWITCH){
+		*reason = "kaku type must be dimmer or switch";
+		return 0;
+	}
+	if(command->fade && command->type != RF_TYPE_DIMMER){
+		*reason = "kaku can only fade a dimmer";
+		return 0;
+	}
+	return 1;
+}
 
+/*
+ * @brief build the pulses of one frame of the command, returns the number of items
+ */
+static int kaku_encode(const RFcommand * command, rmt_item32_t * items, int size)
+{
     //parse the command struct to a kaku
     kaku_frame frame ={
-    		.address = command.address,
-			.unit = command.unit,
-    		.value = command.value
+    		.address = command->address,
+			.unit = command->unit,
+			.group = command->group ? 1 : 0,
+    		.value = command->value
     };
 
     //verify some limits
-    if(frame.unit > 15 || frame.unit < 0)frame.unit = frame.unit%16;
     if(frame.value > 15 )frame.value = frame.value%16;
-    if(frame.unit > 15 )frame.unit = frame.unit%16;
-    if(command.repetitions > 100)command.repetitions = 100;
-    if(command.repetitions < 1)command.repetitions = 25;
+    if(size < KAKU_FRAME_ITEMS)
+    	return 0;
+
+    memset(items, 0, size*sizeof(rmt_item32_t));
+    return kaku_build_frame( items, &frame );
+}
+
+/**
+ * @brief RMT transmitter demo, this task will periodically send NEC data. (100 * 32 bits each time.)
+ *
+ */
+int kaku_sendframe(RFcommand command)
+{
+	int x;
+
+    command.repetitions = kaku_repetitions(&command);
 
     kaku_init();
 
 	//allocate pulse memory
-	rmt_item32_t* item = (rmt_item32_t*) malloc(100*sizeof(rmt_item32_t));
-	memset(item, 0, 100*sizeof(rmt_item32_t));
-	int size = kaku_build_frame( item, &frame );
+	rmt_item32_t* item = (rmt_item32_t*) malloc(KAKU_FRAME_ITEMS*sizeof(rmt_item32_t));
+	if(item == NULL)
+		return 0;
+	int size = kaku_encode( &command, item, KAKU_FRAME_ITEMS );
 
-	//ESP_LOGI(KAKU_TAG, "framesize %2d -address 0x%08x dim %2d unit %d group %d repetitions %d\n", size ,frame.address_state,frame.value, frame.unit ,frame.group, command.repetitions);
-	for(x=0;x<command.repetitions;x++){
+	//ESP_LOGI(KAKU_TAG, "framesize %2d -address 0x%08x dim %2d unit %d group %d repetitions %d\n", size ,command.address,command.value, command.unit ,command.group, command.repetitions);
+	for(x=0;x<command.repetitions && size > 0;x++){
 		//To send data according to the waveform items.
-		rmt_write_items(RMT_TX_CHANNEL, item, 100, true);
+		if(rmt_write_items(RMT_TX_CHANNEL, item, KAKU_FRAME_ITEMS, true) != ESP_OK)
+			break;
 		//Wait until sending is done.
 		rmt_wait_tx_done(RMT_TX_CHANNEL);
 	}
 	//before we free the data, make sure sending is already done.
 	free(item);
+	return x;
 }
+
+const rfProtocol kaku_protocol = {
+		.name = "kaku",
+		.validate = kaku_validate,
+		.encode = kaku_encode,
+		.transmit = kaku_sendframe,
+		.airtime_us = kaku_airtime_us,
+		.stack = KAKU_WORKER_STACK,
+		.priority = KAKU_WORKER_PRIORITY,
+		.depth = KAKU_WORKER_DEPTH,
+};
@@ -8,6 +8,12 @@
 #ifndef MAIN_KAKU_H_
 #define MAIN_KAKU_H_
 
+#include "rfProtocol.h"
+
+#define KAKU_WORKER_STACK		2048
+#define KAKU_WORKER_PRIORITY	10
+#define KAKU_WORKER_DEPTH		32		/*!< commands the kaku worker can hold, bounds the frames of one request */
+
 
 typedef struct {
 	union {
@@ -22,6 +28,9 @@ typedef struct {
 	uint8_t value;
 } kaku_frame;
 
-void kaku_sendframe(RFcommand command);
+extern const rfProtocol kaku_protocol;
+
+int kaku_sendframe(RFcommand command);
+uint32_t kaku_airtime_us(const RFcommand * command);
 
 #endif /* MAIN_KAKU_H_ */
@@ -26,7 +26,8 @@ wifi_config_t sta_config = {
 //void main(){
 void app_main(){
 
-	//setup the dispatcher
+	//setup the dispatcher, its schemas are ready before the server takes requests
+	frameDispatcher_init();
 	xTaskCreate(frameDispatcher_task, "framedisp", 2048, NULL, 10, NULL);
 
 	//init wifi
@@ -0,0 +1,90 @@
+/*
+ * nodeSlab.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  cJSON nodes are all the same size and live for one request or one response.
+ *  Taken from the heap one by one they leave small holes between the buffers of
+ *  Wi-Fi and lwIP. The slab reserves its slots in one block at init and keeps
+ *  the free ones in a list threaded through the slots, alloc and free are a pop
+ *  and a push. A free tells slab slots from heap fallbacks by their address.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "nodeSlab.h"
+
+#define NODESLAB_ALIGN(size)	(((size) + 7) & ~(size_t)7)
+
+typedef struct nodeSlabSlot {
+		struct nodeSlabSlot * next;
+}nodeSlabSlot;
+
+static uint8_t * slab = NULL;
+static size_t slotSize = 0;
+static nodeSlabSlot * freelist = NULL;
+static nodeSlab_stats counters;
+//handlers on both cores allocate nodes
+static portMUX_TYPE slabMux = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+ * @brief reserve count slots of size bytes, returns 0 when there is no memory and everything goes to the heap
+ */
+int nodeSlab_init(size_t size, int count)
+{
+	int i;
+
+	slotSize = NODESLAB_ALIGN(size < sizeof(nodeSlabSlot) ? sizeof(nodeSlabSlot) : size);
+	if((slab = malloc(slotSize * count)) == NULL)
+		return 0;
+
+	//lowest address first
+	for(i = count - 1; i >= 0; i--){
+		nodeSlabSlot * slot = (nodeSlabSlot *)(slab + i * slotSize);
+		slot->next = freelist;
+		freelist = slot;
+	}
+	counters.capacity = count;
+	return 1;
+}
+
+void * nodeSlab_alloc(size_t size)
+{
+	nodeSlabSlot * slot = NULL;
+
+	portENTER_CRITICAL(&slabMux);
+	counters.allocations++;
+	if(size <= slotSize && (slot = freelist) != NULL){
+		freelist = slot->next;
+		if(++counters.in_use > counters.peak)
+			counters.peak = counters.in_use;
+	}else{
+		counters.fallbacks++;
+	}
+	portEXIT_CRITICAL(&slabMux);
+
+	return slot ? (void *)slot : malloc(size);
+}
+
+void nodeSlab_free(void * ptr)
+{
+	nodeSlabSlot * slot = ptr;
+
+	if(slab == NULL || (uint8_t *)ptr < slab || (uint8_t *)ptr >= slab + counters.capacity * slotSize){
+		free(ptr);
+		return;
+	}
+
+	portENTER_CRITICAL(&slabMux);
+	slot->next = freelist;
+	freelist = slot;
+	counters.in_use--;
+	portEXIT_CRITICAL(&slabMux);
+}
+
+void nodeSlab_get_stats(nodeSlab_stats * stats)
+{
+	portENTER_CRITICAL(&slabMux);
+	*stats = counters;
+	portEXIT_CRITICAL(&slabMux);
+}
@@ -0,0 +1,28 @@
+/*
+ * nodeSlab.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_NODESLAB_H_
+#define MAIN_NODESLAB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NODESLAB_NODES		128		/*!< slots reserved once at init, more nodes come from the heap */
+
+typedef struct {
+		uint32_t capacity;			//slots in the slab
+		uint32_t in_use;			//slots handed out now
+		uint32_t peak;				//most slots ever handed out at once
+		uint32_t allocations;
+		uint32_t fallbacks;			//allocations that went to the heap, the slab was full
+}nodeSlab_stats;
+
+int nodeSlab_init(size_t size, int count);
+void * nodeSlab_alloc(size_t size);
+void nodeSlab_free(void * ptr);
+void nodeSlab_get_stats(nodeSlab_stats * stats);
+
+#endif /* MAIN_NODESLAB_H_ */
@@ -0,0 +1,122 @@
+/*
+ * requestArena.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  cJSON allocates every node and every string separately. While a request is
+ *  parsed its task points at an arena through a thread local storage pointer,
+ *  the cJSON hooks carve allocations out of that block and ignore frees, the
+ *  strings go in one free when the request is done. Tasks without an arena,
+ *  and the other handlers, keep using the heap. Nodes never come from the
+ *  arena: they are taken from the node slab and go back to it in cJSON_Delete,
+ *  whichever task or arena that runs in, so a tree is always deleted.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include "requestArena.h"
+#include "nodeSlab.h"
+
+#define REQUESTARENA_ALIGN(size)	(((size) + 7) & ~(size_t)7)
+
+typedef struct requestArenaBlock {
+		struct requestArenaBlock * next;
+		double align;				//keeps the payload aligned for valuedouble
+}requestArenaBlock;
+
+static const char* ARENA_TAG = "ARENA";
+
+static requestArena * requestArena_current()
+{
+	return (requestArena *) pvTaskGetThreadLocalStoragePointer(NULL, REQUESTARENA_TLS_INDEX);
+}
+
+static void * requestArena_malloc(size_t size)
+{
+	requestArena * arena = requestArena_current();
+	requestArenaBlock * block;
+	void * ptr;
+
+	if(arena == NULL)
+		return malloc(size);
+
+	size = REQUESTARENA_ALIGN(size);
+	arena->allocations++;
+	if(arena->used + size <= arena->size){
+		ptr = arena->base + arena->used;
+		arena->used += size;
+		return ptr;
+	}
+
+	//the estimate was short, chain a heap block so it is released with the arena
+	if((block = malloc(sizeof(requestArenaBlock) + size)) == NULL)
+		return NULL;
+	block->next = arena->overflow;
+	arena->overflow = block;
+	arena->overflows++;
+	return block + 1;
+}
+
+static void requestArena_free(void * ptr)
+{
+	//everything allocated during the request goes with the arena
+	if(requestArena_current() == NULL)
+		free(ptr);
+}
+
+/*
+ * @brief route cJSON allocations through the arena of the calling task, nodes through the slab
+ */
+void requestArena_init()
+{
+	cJSON_Hooks hooks = { requestArena_malloc, requestArena_free };
+	cJSON_Hooks nodeHooks = { nodeSlab_alloc, nodeSlab_free };
+
+	cJSON_InitHooks(&hooks);
+	if(!nodeSlab_init(sizeof(cJSON), NODESLAB_NODES))
+		ESP_LOGI(ARENA_TAG,"no memory for the node slab");
+	cJSON_InitNodeHooks(&nodeHooks);
+}
+
+/*
+ * @brief give the calling task an arena sized for a request of request_size bytes
+ *
+ * returns 0 when there is no memory, cJSON then falls back to the heap
+ */
+int requestArena_begin(requestArena * arena, size_t request_size)
+{
+	memset(arena, 0, sizeof(requestArena));
+	arena->size = REQUESTARENA_ALIGN(request_size * REQUESTARENA_FACTOR);
+	if(arena->size < REQUESTARENA_MIN)
+		arena->size = REQUESTARENA_MIN;
+	if((arena->base = malloc(arena->size)) == NULL)
+		return 0;
+
+	vTaskSetThreadLocalStoragePointer(NULL, REQUESTARENA_TLS_INDEX, arena);
+	return 1;
+}
+
+/*
+ * @brief release everything allocated from the arena of the calling task
+ */
+void requestArena_end(requestArena * arena)
+{
+	requestArenaBlock * block;
+
+	if(arena->base == NULL)
+		return;
+
+	vTaskSetThreadLocalStoragePointer(NULL, REQUESTARENA_TLS_INDEX, NULL);
+	while((block = arena->overflow) != NULL){
+		arena->overflow = block->next;
+		free(block);
+	}
+	free(arena->base);
+	arena->base = NULL;
+
+	ESP_LOGD(ARENA_TAG,"%u allocations in %u/%u bytes, %u overflowed",
+			arena->allocations, (unsigned)arena->used, (unsigned)arena->size, arena->overflows);
+}
@@ -0,0 +1,43 @@
+/*
+ * requestArena.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_REQUESTARENA_H_
+#define MAIN_REQUESTARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define REQUESTARENA_FACTOR		4		/*!< arena bytes per request byte, a parse tree is about 4 times its text */
+#define REQUESTARENA_MIN		512
+#define REQUESTARENA_TLS_INDEX	1		/*!< thread local storage slot that points a task at its arena */
+
+//lwIP keeps the netconn semaphore of a thread in its own slot, the arena must not share it
+#if REQUESTARENA_TLS_INDEX == CONFIG_LWIP_THREAD_LOCAL_STORAGE_INDEX
+#error "REQUESTARENA_TLS_INDEX is the thread local storage slot of lwIP"
+#endif
+#if REQUESTARENA_TLS_INDEX >= CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS
+#error "raise CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS for the arena slot"
+#endif
+
+/* bump allocator that holds the strings of the parse tree of one request
+ *
+ * allocations that do not fit in the block are chained and released with it
+ */
+typedef struct {
+		uint8_t * base;
+		size_t size;
+		size_t used;
+		void * overflow;			//chain of allocations that did not fit
+		uint32_t allocations;
+		uint32_t overflows;
+}requestArena;
+
+void requestArena_init();
+int requestArena_begin(requestArena * arena, size_t request_size);
+void requestArena_end(requestArena * arena);
+
+#endif /* MAIN_REQUESTARENA_H_ */
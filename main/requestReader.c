@@ -0,0 +1,162 @@
+/*
+ * requestReader.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  A request used to be parsed once it was complete in one buffer, which only
+ *  held when it fitted in one netbuf. The reader keeps the commandStream state
+ *  between chunks instead, a chunk is read as soon as it arrives and a token
+ *  that is split over two chunks continues where the first one stopped. What is
+ *  kept per request is the stream state and the batch, not the text.
+ *
+ *  Once the stream finds a field it does not read, the batch is dropped and the
+ *  tokenizer alone runs on to the end of the document, the request then goes to
+ *  the cJSON path which needs all of it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "requestReader.h"
+#include "stateCache.h"
+
+static const char* JSON_TAG = "JSON";
+
+static void requestReader_release(requestReader * reader)
+{
+	free(reader->batch);
+	reader->batch = NULL;
+	reader->size = 0;
+	reader->count = 0;
+}
+
+static int requestReader_fail(requestReader * reader)
+{
+	requestReader_release(reader);
+	return reader->state = REQUESTREADER_ERROR;
+}
+
+static int requestReader_append(requestReader * reader, const batchEntry * entry)
+{
+	batchEntry * grown;
+	int size;
+
+	if(reader->count == reader->size){
+		size = reader->size ? reader->size * 2 : REQUESTREADER_BATCH;
+		if((grown = (batchEntry *) realloc(reader->batch, size * sizeof(batchEntry))) == NULL){
+			ESP_LOGI(JSON_TAG,"no memory for %d commands",size);
+			return 0;
+		}
+		reader->batch = grown;
+		reader->size = size;
+	}
+	reader->batch[reader->count++] = *entry;
+	return 1;
+}
+
+/*
+ * @brief the request needs the parse tree, look for the end of the document only
+ */
+static int requestReader_skip(requestReader * reader)
+{
+	for(;;){
+		switch(jsonPull_next(&reader->stream.json)){
+		case JSONPULL_MORE:
+			return REQUESTREADER_MORE;
+		case JSONPULL_END:
+			return reader->state = REQUESTREADER_TREE;
+		case JSONPULL_ERROR:
+			ESP_LOGI(JSON_TAG,"error at byte %u",(unsigned)reader->stream.json.offset);
+			return requestReader_fail(reader);
+		default:
+			break;
+		}
+	}
+}
+
+void requestReader_begin(requestReader * reader, frameDispatcher_result * result)
+{
+	memset(reader, 0, sizeof(requestReader));
+	memset(result, 0, sizeof(frameDispatcher_result));
+	reader->defaults.fresh_ms = STATECACHE_FRESH_MS;
+	reader->result = result;
+	commandStream_init(&reader->stream, &reader->defaults);
+}
+
+/*
+ * @brief read the next chunk of the request
+ *
+ * the chunk is used up when this returns, bytes after the end of the document
+ * are ignored
+ */
+int requestReader_feed(requestReader * reader, const char * data, size_t length)
+{
+	batchEntry entry;
+
+	if(reader->state != REQUESTREADER_MORE)
+		return reader->state;
+	commandStream_feed(&reader->stream, data, length);
+
+	while(reader->state == REQUESTREADER_MORE){
+		if(reader->tree)
+			return requestReader_skip(reader);
+
+		switch(commandStream_next(&reader->stream, &entry)){
+		case COMMANDSTREAM_MORE:
+			return REQUESTREADER_MORE;
+
+		case COMMANDSTREAM_COMMAND:
+			if(frameDispatcher_check(&entry, reader->stream.protocol, NULL, reader->stream.commands - 1, reader->result) < 0
+					|| !requestReader_append(reader, &entry))
+				return requestReader_fail(reader);
+			break;
+
+		case COMMANDSTREAM_SKIPPED:
+			frameDispatcher_check(NULL, reader->stream.protocol, reader->stream.missing, reader->stream.commands - 1, reader->result);
+			break;
+
+		case COMMANDSTREAM_END:
+			//without commands the request is cancel only or broken, cJSON tells which
+			if(!reader->stream.has_commands){
+				requestReader_release(reader);
+				reader->state = REQUESTREADER_TREE;
+			}else{
+				reader->state = REQUESTREADER_DONE;
+			}
+			break;
+
+		case COMMANDSTREAM_UNSUPPORTED:
+			requestReader_release(reader);
+			reader->tree = 1;
+			break;
+
+		default:
+			ESP_LOGI(JSON_TAG,"error at byte %u",(unsigned)reader->stream.json.offset);
+			return requestReader_fail(reader);
+		}
+	}
+	return reader->state;
+}
+
+/*
+ * @brief queue the commands of a complete plain request, the batch is handed to the dispatcher
+ *
+ * returns the number of parsed commands, -1 when the request was rejected or
+ * the input ended before the document did
+ */
+int requestReader_finish(requestReader * reader)
+{
+	batchEntry * batch = reader->batch;
+
+	if(reader->state == REQUESTREADER_DONE){
+		reader->batch = NULL;
+		reader->result->parsed = reader->stream.commands;
+		return frameDispatcher_batch_to_queu(batch, reader->count, reader->stream.optimize, reader->result);
+	}
+	if(reader->state == REQUESTREADER_MORE){
+		snprintf(reader->result->error, FRAMEDISPATCHER_ERROR_SIZE, "request cut off after %u bytes", (unsigned)reader->stream.json.offset);
+		ESP_LOGI(JSON_TAG,"%s",reader->result->error);
+	}
+	requestReader_release(reader);
+	return -1;
+}
@@ -0,0 +1,47 @@
+/*
+ * requestReader.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_REQUESTREADER_H_
+#define MAIN_REQUESTREADER_H_
+
+#include "commandStream.h"
+
+#define REQUESTREADER_BATCH		8		/*!< first allocation of the batch, doubled as needed */
+
+enum requestReaderResults
+{
+	REQUESTREADER_MORE = 0,		//feed the next chunk
+	REQUESTREADER_DONE,			//the request is complete, finish queues it
+	REQUESTREADER_TREE,			//the request is complete but needs the cJSON path, nothing was queued
+	REQUESTREADER_ERROR			//the request is broken or a command was rejected, the reason is in the result
+};
+
+/* reads a request chunk by chunk as it comes off the network
+ *
+ * the commands of a plain request are collected while the chunks arrive, a
+ * chunk can be dropped once it was fed. A request that needs the parse tree is
+ * still read to its end, so the caller knows how much of it to hand to cJSON
+ */
+typedef struct {
+		commandStream stream;
+		batchEntry defaults;
+		batchEntry * batch;			//commands read so far
+		int size;
+		int count;
+		int state;					//REQUESTREADER_*
+		int tree;					//'1' once the request needs cJSON, only its end is looked for
+		frameDispatcher_result * result;
+}requestReader;
+
+void requestReader_begin(requestReader * reader, frameDispatcher_result * result);
+int requestReader_feed(requestReader * reader, const char * data, size_t length);
+int requestReader_finish(requestReader * reader);
+
+/* dispatcher side of the reader, see frameDispatcher.c */
+int frameDispatcher_check(const batchEntry * entry, const char * protocol, const char * missing, int index, frameDispatcher_result * result);
+int frameDispatcher_batch_to_queu(batchEntry * batch, int count, int optimize, frameDispatcher_result * result);
+
+#endif /* MAIN_REQUESTREADER_H_ */
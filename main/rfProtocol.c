@@ -0,0 +1,48 @@
+/*
+ * rfProtocol.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Registry of the protocols the bridge can transmit, indexed by protocol id so
+ *  the dispatcher jumps straight to the operations of a command.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "rfProtocol.h"
+#include "kaku.h"
+
+static const rfProtocol * const registry[RF_PROTOCOLS] = {
+		[RF_PROTOCOL_KAKU] = &kaku_protocol,
+};
+
+/*
+ * @brief operations of a protocol id, NULL when nothing is registered for it
+ */
+const rfProtocol * rfProtocol_get(int protocol)
+{
+	if(protocol <= RF_PROTOCOL_UNKNOWN || protocol >= RF_PROTOCOLS)
+		return NULL;
+	return registry[protocol];
+}
+
+/*
+ * @brief protocol id by name, RF_PROTOCOL_UNKNOWN when no such protocol is registered
+ */
+int rfProtocol_id(const char * name)
+{
+	int i;
+
+	for(i = RF_PROTOCOL_UNKNOWN + 1; name != NULL && i < RF_PROTOCOLS; i++){
+		if(registry[i] != NULL && strcmp(name, registry[i]->name) == 0)
+			return i;
+	}
+	return RF_PROTOCOL_UNKNOWN;
+}
+
+const char * rfProtocol_name(int protocol)
+{
+	const rfProtocol * ops = rfProtocol_get(protocol);
+
+	return ops ? ops->name : "unknown";
+}
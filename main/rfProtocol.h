@@ -0,0 +1,29 @@
+/*
+ * rfProtocol.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_RFPROTOCOL_H_
+#define MAIN_RFPROTOCOL_H_
+
+#include "driver/rmt.h"
+#include "frameDispatcher.h"
+
+/* operations of a protocol, registered in rfProtocol.c under its RF_PROTOCOL_* id */
+typedef struct {
+		const char * name;
+		int (*validate)(const RFcommand * command, const char ** reason);	//0 with a reason when the command cannot be sent
+		int (*encode)(const RFcommand * command, rmt_item32_t * items, int size);	//pulses of one frame, returns the item count
+		int (*transmit)(RFcommand command);	//returns the frames that went on air, 0 when it failed
+		uint32_t (*airtime_us)(const RFcommand * command);	//all repetitions of the command
+		uint32_t stack;				//worker task of the transmitter
+		UBaseType_t priority;
+		UBaseType_t depth;			//commands its worker can hold, requests beyond that are turned away
+}rfProtocol;
+
+const rfProtocol * rfProtocol_get(int protocol);
+int rfProtocol_id(const char * name);
+const char * rfProtocol_name(int protocol);
+
+#endif /* MAIN_RFPROTOCOL_H_ */
@@ -0,0 +1,123 @@
+/*
+ * rfRing.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Lock-free ring between the request parser and a transmitter worker. The
+ *  indices run freely and are masked on access, head - tail is the fill level.
+ *  The producer publishes the command before it moves head and the consumer
+ *  reads it before it moves tail, the barriers keep the two cores from seeing
+ *  those stores out of order.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "rfRing.h"
+
+#define rfRing_barrier()	__sync_synchronize()
+
+/*
+ * @brief allocate the slots of a ring, size is rounded up to a power of 2
+ */
+int rfRing_init(rfRing * ring, uint32_t size)
+{
+	uint32_t slots = 1;
+
+	while(slots < size)
+		slots <<= 1;
+
+	memset(ring, 0, sizeof(rfRing));
+	if((ring->items = malloc(slots * sizeof(RFcommand))) == NULL)
+		return 0;
+	ring->mask = slots - 1;
+	return 1;
+}
+
+/*
+ * @brief task that is notified when commands arrive in the empty ring
+ */
+void rfRing_attach(rfRing * ring, TaskHandle_t consumer)
+{
+	ring->consumer = consumer;
+}
+
+/*
+ * @brief producer side, returns 0 when count more commands do not fit
+ *
+ * the consumer only ever frees slots, so what is reserved stays available until
+ * the producer publishes it
+ */
+int rfRing_reserve(rfRing * ring, uint32_t count)
+{
+	return ring->head + ring->staged + count - ring->tail <= ring->mask + 1;
+}
+
+/*
+ * @brief producer side, write a reserved command, it stays invisible to the consumer
+ */
+void rfRing_stage(rfRing * ring, const RFcommand * command)
+{
+	ring->items[(ring->head + ring->staged) & ring->mask] = *command;
+	ring->staged++;
+}
+
+/*
+ * @brief producer side, hand every staged command to the consumer at once
+ */
+void rfRing_publish(rfRing * ring)
+{
+	uint32_t head = ring->head;
+
+	if(ring->staged == 0)
+		return;
+
+	rfRing_barrier();
+	ring->head = head + ring->staged;
+	ring->staged = 0;
+
+	//tail is read after head is published, either the consumer sees the new
+	//commands before it sleeps or we see it drained the ring and wake it
+	rfRing_barrier();
+	if(ring->tail == head && ring->consumer != NULL){
+		ring->wakeups++;
+		xTaskNotifyGive(ring->consumer);
+	}
+}
+
+/*
+ * @brief producer side, returns 0 when the ring is full
+ */
+int rfRing_push(rfRing * ring, const RFcommand * command)
+{
+	if(!rfRing_reserve(ring, 1))
+		return 0;
+
+	rfRing_stage(ring, command);
+	rfRing_publish(ring);
+	return 1;
+}
+
+/*
+ * @brief consumer side, returns 0 when the ring is empty
+ */
+int rfRing_pop(rfRing * ring, RFcommand * command)
+{
+	uint32_t tail = ring->tail;
+
+	if(tail == ring->head)
+		return 0;
+
+	rfRing_barrier();
+	*command = ring->items[tail & ring->mask];
+	rfRing_barrier();
+	ring->tail = tail + 1;
+	rfRing_barrier();
+	return 1;
+}
+
+/*
+ * @brief commands waiting in the ring
+ */
+uint32_t rfRing_count(const rfRing * ring)
+{
+	return ring->head - ring->tail;
+}
@@ -0,0 +1,39 @@
+/*
+ * rfRing.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_RFRING_H_
+#define MAIN_RFRING_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "frameDispatcher.h"
+
+/* single producer, single consumer ring of commands
+ *
+ * head is only written by the producer and tail only by the consumer, so neither
+ * side takes a lock. The consumer task is notified when the ring goes from empty
+ * to non-empty, a burst of commands costs one wakeup.
+ */
+typedef struct {
+		RFcommand * items;
+		uint32_t mask;				//size - 1, size is a power of 2
+		volatile uint32_t head;		//next slot the producer writes
+		volatile uint32_t tail;		//next slot the consumer reads
+		uint32_t staged;			//written by the producer but not yet published
+		TaskHandle_t consumer;		//notified on the empty to non-empty transition
+		uint32_t wakeups;
+}rfRing;
+
+int rfRing_init(rfRing * ring, uint32_t size);
+void rfRing_attach(rfRing * ring, TaskHandle_t consumer);
+int rfRing_reserve(rfRing * ring, uint32_t count);
+void rfRing_stage(rfRing * ring, const RFcommand * command);
+void rfRing_publish(rfRing * ring);
+int rfRing_push(rfRing * ring, const RFcommand * command);
+int rfRing_pop(rfRing * ring, RFcommand * command);
+uint32_t rfRing_count(const rfRing * ring);
+
+#endif /* MAIN_RFRING_H_ */
@@ -0,0 +1,248 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Hashed timer wheel for delayed and recurring commands. Every entry hangs in
+ *  the slot of its expiry tick in a doubly linked list, so insert, cancel and
+ *  expiry are O(1) regardless of how many entries are pending. The wheel is
+ *  advanced by a one-shot software timer that only re-arms itself while entries
+ *  are pending, due commands are pushed straight into the command queue from the
+ *  timer task so the dispatcher is only woken for real work. An entry keeps the
+ *  parameters of its fade, not a fade slot: every run reserves its own slot just
+ *  before it is queued, so nothing is held while the entry waits or is cancelled.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+#include "scheduler.h"
+
+#define SCHEDULER_SLOT_MASK		(SCHEDULER_WHEEL_SLOTS - 1)
+#define SCHEDULER_INDEX_BITS	16
+#define SCHEDULER_INDEX_MASK	((1 << SCHEDULER_INDEX_BITS) - 1)
+#define SCHEDULER_GEN_MASK		0x7FFF
+
+enum schedulerStates
+{
+	SCHED_FREE = 0,
+	SCHED_WAITING,		//linked in a wheel slot
+	SCHED_FIRING		//taken out of the wheel by the timer, being queued
+};
+
+typedef struct schedulerEntry {
+		struct schedulerEntry * next;
+		struct schedulerEntry * prev;
+		RFcommand command;			//fade is '1' for a fade, the slot is reserved per run
+		fadeRequest fade;
+		uint32_t expiry;			//wheel tick at which the command is due
+		uint32_t interval;			//ticks between repetitions, 0 for a one-shot
+		uint16_t generation;		//invalidates ids of entries that were reused
+		uint8_t state;
+		uint8_t cancelled;			//cancelled while firing, released by the timer
+}schedulerEntry;
+
+static const char* SCHED_TAG = "SCHED";
+
+static schedulerEntry entries[SCHEDULER_MAX_ENTRIES];
+static schedulerEntry * wheel[SCHEDULER_WHEEL_SLOTS];
+static schedulerEntry * freelist = NULL;
+static uint32_t wheel_now = 0;
+static int pending = 0;
+static int armed = 0;
+static TimerHandle_t wheelTimer = NULL;
+static portMUX_TYPE wheelMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void scheduler_link(schedulerEntry * entry)
+{
+	schedulerEntry ** slot = &wheel[entry->expiry & SCHEDULER_SLOT_MASK];
+
+	entry->prev = NULL;
+	entry->next = *slot;
+	if(*slot != NULL)
+		(*slot)->prev = entry;
+	*slot = entry;
+}
+
+static void scheduler_unlink(schedulerEntry * entry)
+{
+	if(entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		wheel[entry->expiry & SCHEDULER_SLOT_MASK] = entry->next;
+	if(entry->next != NULL)
+		entry->next->prev = entry->prev;
+}
+
+static void scheduler_release(schedulerEntry * entry)
+{
+	entry->state = SCHED_FREE;
+	entry->generation = (entry->generation + 1) & SCHEDULER_GEN_MASK;
+	entry->next = freelist;
+	freelist = entry;
+	pending--;
+}
+
+static uint32_t scheduler_ms_to_ticks(uint32_t ms)
+{
+	uint32_t ticks = (ms + SCHEDULER_TICK_MS - 1) / SCHEDULER_TICK_MS;
+	return ticks ? ticks : 1;
+}
+
+/*
+ * @brief queue one run of an entry without blocking, returns 0 when the queue is full
+ */
+static int scheduler_fire(const schedulerEntry * entry)
+{
+	RFcommand command = entry->command;
+
+	if(command.fade)
+		command.fade = fadeEngine_prepare(&command, &entry->fade);
+	if(frameDispatcher_enqueue(&command, 0))
+		return 1;
+	fadeEngine_release(command.fade);
+	return 0;
+}
+
+/*
+ * @brief timer callback, advances the wheel by one tick and queues what is due
+ */
+static void scheduler_tick(TimerHandle_t timer)
+{
+	schedulerEntry * due = NULL;
+	schedulerEntry * entry;
+	schedulerEntry * next;
+
+	//unlink everything that expires on this tick
+	portENTER_CRITICAL(&wheelMux);
+	wheel_now++;
+	for(entry = wheel[wheel_now & SCHEDULER_SLOT_MASK]; entry != NULL; entry = next){
+		next = entry->next;
+		if(entry->expiry == wheel_now){
+			scheduler_unlink(entry);
+			entry->state = SCHED_FIRING;
+			entry->next = due;
+			due = entry;
+		}
+	}
+	portEXIT_CRITICAL(&wheelMux);
+
+	//queue without blocking the timer task, a full queue retries on the next tick
+	for(entry = due; entry != NULL; entry = next){
+		next = entry->next;
+		int queued = entry->cancelled ? 0 : scheduler_fire(entry);
+
+		portENTER_CRITICAL(&wheelMux);
+		if(entry->cancelled || (queued && !entry->interval)){
+			scheduler_release(entry);
+		}else{
+			entry->expiry = wheel_now + (queued ? entry->interval : 1);
+			entry->state = SCHED_WAITING;
+			scheduler_link(entry);
+		}
+		portEXIT_CRITICAL(&wheelMux);
+	}
+
+	//only keep ticking while there is something to wait for
+	portENTER_CRITICAL(&wheelMux);
+	armed = pending > 0;
+	portEXIT_CRITICAL(&wheelMux);
+	if(armed)
+		xTimerStart(timer, 0);
+}
+
+/*
+ * @brief set up the entry pool and the wheel timer
+ */
+void scheduler_init()
+{
+	int i;
+
+	esp_log_level_set(SCHED_TAG, ESP_LOG_INFO);
+
+	memset(entries, 0, sizeof(entries));
+	memset(wheel, 0, sizeof(wheel));
+	for(i = SCHEDULER_MAX_ENTRIES - 1; i >= 0; i--){
+		entries[i].next = freelist;
+		freelist = &entries[i];
+	}
+
+	wheelTimer = xTimerCreate("schedwheel", SCHEDULER_TICK_MS / portTICK_PERIOD_MS, pdFALSE, NULL, scheduler_tick);
+}
+
+/*
+ * @brief schedule a command after delay_ms, repeating every interval_ms when not 0
+ *
+ * a command marked as a fade gets a fade slot with the parameters in fade on
+ * every run. Returns the id to cancel the entry with or -1 when the wheel is full
+ */
+int scheduler_add(const RFcommand * command, uint32_t delay_ms, uint32_t interval_ms, const fadeRequest * fade)
+{
+	schedulerEntry * entry;
+	int start = 0;
+	int id;
+
+	if(wheelTimer == NULL)
+		return -1;
+
+	portENTER_CRITICAL(&wheelMux);
+	if((entry = freelist) == NULL){
+		portEXIT_CRITICAL(&wheelMux);
+		ESP_LOGI(SCHED_TAG,"no free entries");
+		return -1;
+	}
+	freelist = entry->next;
+	pending++;
+
+	entry->command = *command;
+	if(command->fade)
+		entry->fade = *fade;
+	entry->interval = interval_ms ? scheduler_ms_to_ticks(interval_ms) : 0;
+	entry->expiry = wheel_now + scheduler_ms_to_ticks(delay_ms ? delay_ms : interval_ms);
+	entry->state = SCHED_WAITING;
+	entry->cancelled = 0;
+	scheduler_link(entry);
+	id = (entry->generation << SCHEDULER_INDEX_BITS) | (entry - entries);
+
+	if(!armed){
+		armed = 1;
+		start = 1;
+	}
+	portEXIT_CRITICAL(&wheelMux);
+
+	if(start)
+		xTimerStart(wheelTimer, 10);
+
+	return id;
+}
+
+/*
+ * @brief remove a pending entry, returns 1 when it was still scheduled
+ */
+int scheduler_cancel(int id)
+{
+	int index = id & SCHEDULER_INDEX_MASK;
+	schedulerEntry * entry;
+	int found = 0;
+
+	if(id < 0 || index >= SCHEDULER_MAX_ENTRIES)
+		return 0;
+
+	entry = &entries[index];
+	portENTER_CRITICAL(&wheelMux);
+	if(entry->state != SCHED_FREE && !entry->cancelled &&
+			entry->generation == ((id >> SCHEDULER_INDEX_BITS) & SCHEDULER_GEN_MASK)){
+		if(entry->state == SCHED_WAITING){
+			scheduler_unlink(entry);
+			scheduler_release(entry);
+		}else{
+			entry->cancelled = 1;
+		}
+		found = 1;
+	}
+	portEXIT_CRITICAL(&wheelMux);
+
+	return found;
+}
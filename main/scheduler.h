@@ -0,0 +1,21 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_SCHEDULER_H_
+#define MAIN_SCHEDULER_H_
+
+#include "frameDispatcher.h"
+#include "fadeEngine.h"
+
+#define SCHEDULER_TICK_MS		100		/*!< resolution of the timer wheel */
+#define SCHEDULER_WHEEL_SLOTS	256		/*!< number of wheel slots, must be a power of 2 */
+#define SCHEDULER_MAX_ENTRIES	128		/*!< scheduled commands that can be pending at once */
+
+void scheduler_init();
+int scheduler_add(const RFcommand * command, uint32_t delay_ms, uint32_t interval_ms, const fadeRequest * fade);
+int scheduler_cancel(int id);
+
+#endif /* MAIN_SCHEDULER_H_ */
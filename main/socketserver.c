@@ -19,12 +19,20 @@
 #include "esp_log.h"
 #include "tcpip_adapter.h"
 #include "frameDispatcher.h"
+#include "stateCache.h"
+#include "socketserver.h"
+#include "requestArena.h"
+#include "jobTracker.h"
+#include "requestReader.h"
 static EventGroupHandle_t wifi_event_group;
 const int CONNECTED_BIT = BIT0;
 //static char* TAG = "app_main";
+static const char* SERVER_TAG = "SERVER";
 
 #include "lwip/err.h"
 #include "string.h"
+#include "stdlib.h"
+#include "stdarg.h"
 
 #include "cJSON.h"
 
@@ -39,6 +47,7 @@ wifi_config_t sta_config;
 uint16_t portnumber = 8000;
 
 static void http_server(void *pvParameters);
+static void http_server_start(void);
 static void initialise_wifi(void);
 static esp_err_t event_handler(void *ctx, system_event_t *event);
 
@@ -46,6 +55,16 @@ const static char http_html_hdr_200[] =
     "HTTP/1.1 200 OK\r\nContent-type: text/html\r\n\r\n";
 const static char http_html_hdr_400[] =
     "HTTP/1.1 400 OK\r\nContent-type: text/html\r\n\r\n";
+const static char http_html_hdr_503[] =
+    "HTTP/1.1 503 Service Unavailable\r\nRetry-After: %u\r\nContent-type: text/html\r\n\r\n%s\r\n";
+const static char http_json_hdr_200[] =
+    "HTTP/1.1 200 OK\r\nContent-type: application/json\r\n\r\n";
+const static char http_get_state[] = "GET /state";
+const static char http_get_workers[] = "GET /workers";
+const static char http_get_jobs[] = "GET /jobs";
+const static char http_jobs_range[] = "job ids are 1..65535\r\n";
+const static char http_json_hdr_202[] =
+    "HTTP/1.1 202 Accepted\r\nContent-type: application/json\r\n\r\n{\"job\":%s,\"parsed\":%d,\"queued\":%d,\"scheduled\":%d,\"duplicate\":%s}";
 
 
 int init_socketserver(wifi_config_t * config, uint16_t port)
@@ -57,8 +76,9 @@ int init_socketserver(wifi_config_t * config, uint16_t port)
 
 	nvs_flash_init();
     system_init();
+    requestArena_init();
     initialise_wifi();
-    xTaskCreate((TaskFunction_t)&http_server, "http_server", 2048, NULL, 5, NULL);
+    http_server_start();
 
     return 0;
 }
@@ -104,18 +124,266 @@ static esp_err_t event_handler(void *ctx, system_event_t *event)
 }
 
 
+/* HTTP headers in front of the json, 0 to 3 while in the headers: bytes of the blank line that ends them */
+enum httpHeaderStates
+{
+	HTTP_HEADERS_UNKNOWN = -1,		//nothing seen yet
+	HTTP_HEADERS_BODY = 4			//past the headers, or a bare json request
+};
+
+/*
+ * @brief bytes at the start of the chunk that still belong to the HTTP headers
+ *
+ * a bare json request starts with the document itself, an HTTP one with its
+ * request line. state carries the match of the blank line from chunk to chunk
+ */
+static u16_t
+http_server_headers(int *state, const char *data, u16_t len)
+{
+  static const char blank[] = "\r\n\r\n";
+  u16_t i;
+
+  if (*state == HTTP_HEADERS_UNKNOWN && len > 0)
+    *state = (data[0] >= 'A' && data[0] <= 'Z') ? 0 : HTTP_HEADERS_BODY;
+  for (i = 0; i < len && *state < HTTP_HEADERS_BODY; i++) {
+    if (data[i] == blank[*state])
+      (*state)++;
+    else
+      *state = data[i] == '\r' ? 1 : 0;
+  }
+  return i;
+}
+
+/*
+ * @brief hand a request that needs the parse tree to cJSON, its tree lives in an arena sized from the request
+ *
+ * in place when the request is in one pbuf, cJSON needs it in one block otherwise.
+ * Either way its strings are unescaped inside the buffer, the pbuf is ours until netbuf_delete
+ */
+static int
+http_server_tree_to_queu(struct netbuf *inbuf, u16_t body, frameDispatcher_result *result, requestArena *arena)
+{
+  u16_t length = netbuf_len(inbuf) - body;
+  char *data;
+  char *copy = NULL;
+  u16_t len;
+  int noc;
+
+  netbuf_first(inbuf);
+  netbuf_data(inbuf, (void**)&data, &len);
+  if (len < netbuf_len(inbuf)) {
+    if ((copy = malloc(length)) == NULL) {
+      snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "no memory for a request of %u bytes", length);
+      return -1;
+    }
+    netbuf_copy_partial(inbuf, copy, length, body);
+    data = copy;
+  }
+  else {
+    data += body;
+  }
+
+  requestArena_begin(arena, length);
+  noc = frameDispatcher_tree_to_queu(data, length, result);
+  requestArena_end(arena);
+  free(copy);
+  return noc;
+}
+
+/*
+ * @brief read a request that may span several pbufs and netconn_recv calls, and queue its commands
+ *
+ * every pbuf is fed to the reader as it arrives, a token split over two of them
+ * continues where the first one stopped. The netbufs are chained to inbuf since
+ * a request that turns out to need cJSON is parsed from all of them at the end
+ */
+static int
+http_server_read_request(struct netconn *conn, struct netbuf *inbuf, frameDispatcher_result *result, requestArena *arena)
+{
+  requestReader reader;
+  struct netbuf *next = inbuf;
+  int headers = HTTP_HEADERS_UNKNOWN;
+  u16_t body = 0;
+  u16_t skip;
+  char *data;
+  u16_t len;
+  int state;
+  int noc;
+
+  requestReader_begin(&reader, result);
+  do {
+    netbuf_first(next);
+    do {
+      netbuf_data(next, (void**)&data, &len);
+      skip = http_server_headers(&headers, data, len);
+      body += skip;
+      state = requestReader_feed(&reader, data + skip, len - skip);
+    } while (state == REQUESTREADER_MORE && netbuf_next(next) >= 0);
+    if (next != inbuf)
+      netbuf_chain(inbuf, next);
+  } while (state == REQUESTREADER_MORE && netbuf_len(inbuf) < SOCKETSERVER_REQUEST_MAX
+      && netconn_recv(conn, &next) == ERR_OK);
+
+  if (state == REQUESTREADER_TREE)
+    return http_server_tree_to_queu(inbuf, body, result, arena);
+
+  noc = requestReader_finish(&reader);
+  if (state == REQUESTREADER_MORE && netbuf_len(inbuf) >= SOCKETSERVER_REQUEST_MAX)
+    snprintf(result->error, FRAMEDISPATCHER_ERROR_SIZE, "request larger than %d bytes", SOCKETSERVER_REQUEST_MAX);
+  return noc;
+}
+
+/*
+ * @brief answer GET /state with the last known state of every unit, the radio is not touched
+ */
+static void
+http_server_send_state(struct netconn *conn)
+{
+  cJSON *states = stateCache_to_json(xTaskGetTickCount());
+  char *body = states ? cJSON_PrintUnformatted(states) : NULL;
+
+  if (body == NULL) {
+    netconn_write(conn, http_html_hdr_400, sizeof(http_html_hdr_400)-1, NETCONN_NOCOPY);
+  } else {
+    netconn_write(conn, http_json_hdr_200, sizeof(http_json_hdr_200)-1, NETCONN_NOCOPY);
+    netconn_write(conn, body, strlen(body), NETCONN_COPY);
+    free(body);
+  }
+  cJSON_Delete(states);
+}
+
+/*
+ * @brief answer GET /workers with the queue depth and utilization of every transmitter worker
+ */
+static void
+http_server_send_workers(struct netconn *conn)
+{
+  frameDispatcher_workerStats stats;
+  cJSON *workers = cJSON_CreateArray();
+  cJSON *worker;
+  char *body;
+  int i;
+
+  for (i = 0; workers != NULL && frameDispatcher_worker_stats(i, &stats); i++) {
+    if ((worker = cJSON_CreateObject()) == NULL)
+      continue;
+    cJSON_AddStringToObject(worker, "protocol", stats.protocol);
+    cJSON_AddNumberToObject(worker, "depth", stats.depth);
+    cJSON_AddNumberToObject(worker, "depth_max", stats.depth_max);
+    cJSON_AddNumberToObject(worker, "capacity", stats.capacity);
+    cJSON_AddNumberToObject(worker, "sent", stats.sent);
+    cJSON_AddNumberToObject(worker, "rejected", stats.rejected);
+    cJSON_AddNumberToObject(worker, "utilization", stats.utilization);
+    cJSON_AddNumberToObject(worker, "wakeups", stats.wakeups);
+    cJSON_AddNumberToObject(worker, "backlog_ms", stats.backlog_ms);
+    cJSON_AddItemToArray(workers, worker);
+  }
+
+  if ((body = workers ? cJSON_PrintUnformatted(workers) : NULL) == NULL) {
+    netconn_write(conn, http_html_hdr_400, sizeof(http_html_hdr_400)-1, NETCONN_NOCOPY);
+  } else {
+    netconn_write(conn, http_json_hdr_200, sizeof(http_json_hdr_200)-1, NETCONN_NOCOPY);
+    netconn_write(conn, body, strlen(body), NETCONN_COPY);
+    free(body);
+  }
+  cJSON_Delete(workers);
+}
+
+/*
+ * @brief answer GET /jobs?id=1,2,3 with the records of those jobs, GET /jobs with every known job
+ */
 static void
-http_server_netconn_serve(struct netconn *conn)
+http_server_send_jobs(struct netconn *conn, const char *buf, u16_t buflen)
+{
+  uint16_t ids[JOBTRACKER_JOBS];
+  int count = 0;
+  const char *p = buf + sizeof(http_get_jobs) - 1;
+  const char *end = buf + buflen;
+  cJSON *jobs;
+  char *body;
+
+  if (p + 4 <= end && strncmp(p, "?id=", 4) == 0) {
+    for (p += 4; p < end && count < JOBTRACKER_JOBS && *p >= '0' && *p <= '9'; ) {
+      uint32_t id = 0;
+      while (p < end && *p >= '0' && *p <= '9' && id <= UINT16_MAX)
+        id = id * 10 + (*p++ - '0');
+      //job ids are 16 bits, a larger one must not alias a live job
+      if (id > UINT16_MAX) {
+        netconn_write(conn, http_html_hdr_400, sizeof(http_html_hdr_400)-1, NETCONN_NOCOPY);
+        netconn_write(conn, http_jobs_range, sizeof(http_jobs_range)-1, NETCONN_NOCOPY);
+        return;
+      }
+      ids[count++] = id;
+      if (p < end && *p == ',')
+        p++;
+    }
+  }
+
+  jobs = jobTracker_to_json(ids, count);
+  if ((body = jobs ? cJSON_PrintUnformatted(jobs) : NULL) == NULL) {
+    netconn_write(conn, http_html_hdr_400, sizeof(http_html_hdr_400)-1, NETCONN_NOCOPY);
+  } else {
+    netconn_write(conn, http_json_hdr_200, sizeof(http_json_hdr_200)-1, NETCONN_NOCOPY);
+    netconn_write(conn, body, strlen(body), NETCONN_COPY);
+    free(body);
+  }
+  cJSON_Delete(jobs);
+}
+
+/*
+ * @brief append formatted text to the response in buf, returns the new length
+ *
+ * text that does not fit is cut off, the length never exceeds what buf holds
+ */
+static int __attribute__((format(printf, 4, 5)))
+http_server_append(char *buf, int len, int size, const char *format, ...)
+{
+  va_list args;
+  int n;
+
+  if (len >= size - 1)
+    return len;
+  va_start(args, format);
+  n = vsnprintf(buf + len, size - len, format, args);
+  va_end(args);
+  if (n < 0)
+    return len;
+  return len + n < size ? len + n : size - 1;
+}
+
+/*
+ * @brief what a handler keeps per request besides the reader, allocated once per
+ * handler so the response and the result do not sit on its stack next to the
+ * reader and the cJSON recursion
+ */
+typedef struct {
+  char respbuf[448];
+  frameDispatcher_result result;
+  requestArena arena;
+  jobTracker_job job;
+  UBaseType_t stack_low;		//fewest stack bytes left so far
+} http_server_context;
+
+static void
+http_server_netconn_serve(struct netconn *conn, http_server_context *ctx)
 {
   struct netbuf *inbuf;
   char *buf;
   u16_t buflen;
   int noc;
+  int resplen;
+  int i;
   err_t err;
-  char respbuf[40] = {0};
+  char jobid[8];
+  char *respbuf = ctx->respbuf;
+  const size_t respsize = sizeof(ctx->respbuf);
+  frameDispatcher_result *result = &ctx->result;
+  jobTracker_job *job = &ctx->job;
+  int waited;
 
   /* Read the data from the port, blocking if nothing yet there.
-   We assume the request (the part we care about) is in one netbuf */
+   The GET requests are recognised from the first netbuf, a json
+   request is read on from the following ones until it is complete */
   err = netconn_recv(conn, &inbuf);
 
   if (err == ERR_OK) {
@@ -123,13 +391,71 @@ http_server_netconn_serve(struct netconn *conn)
 
     //printf("buffer = %s \n", buf);
 
-    if((noc = frameDispatcher_json_to_queu(buf))<0){
+    if (buflen >= sizeof(http_get_state)-1 && strncmp(buf, http_get_state, sizeof(http_get_state)-1) == 0) {
+    	http_server_send_state(conn);
+    }
+    else if (buflen >= sizeof(http_get_workers)-1 && strncmp(buf, http_get_workers, sizeof(http_get_workers)-1) == 0) {
+    	http_server_send_workers(conn);
+    }
+    else if (buflen >= sizeof(http_get_jobs)-1 && strncmp(buf, http_get_jobs, sizeof(http_get_jobs)-1) == 0) {
+    	http_server_send_jobs(conn, buf, buflen);
+    }
+    else if((noc = http_server_read_request(conn, inbuf, result, &ctx->arena))<0 && result->busy){
+    	//the transmitter is backed up, the client retries instead of holding up the server
+    	resplen = http_server_append(respbuf, 0, respsize, http_html_hdr_503, result->retry_after, result->error);
+    	netconn_write(conn, respbuf, resplen, NETCONN_COPY);
+    }
+    else if(noc < 0){
     	netconn_write(conn, http_html_hdr_400, sizeof(http_html_hdr_400)-1, NETCONN_NOCOPY);
+    	if(result->error[0]){
+    		resplen = http_server_append(respbuf, 0, respsize, "%s\r\n", result->error);
+    		netconn_write(conn, respbuf, resplen, NETCONN_COPY);
+    	}
+    }
+    else if(result->async){
+    	//the radio is never waited for, the client polls GET /jobs. Without a queued frame,
+    	//every command delayed or suppressed, there is no job and it is reported as null
+    	if(result->job)
+    		http_server_append(jobid, 0, sizeof(jobid), "%u", result->job);
+    	resplen = http_server_append(respbuf, 0, respsize, http_json_hdr_202, result->job ? jobid : "null",
+    			noc, result->queued, result->scheduled, result->duplicate ? "true" : "false");
+    	netconn_write(conn, respbuf, resplen, NETCONN_COPY);
     }
     else{
+    	//in wait mode the answer goes out once the frames are on air, or when the wait times out
+    	waited = result->job && jobTracker_wait(result->job, result->wait_ms / portTICK_PERIOD_MS, job);
     	netconn_write(conn, http_html_hdr_200, sizeof(http_html_hdr_200)-1, NETCONN_NOCOPY);
-    	sprintf((char *)respbuf,"Number of parsed commands %4d\r\n",noc);
-    	netconn_write(conn, respbuf, sizeof(respbuf), NETCONN_NOCOPY);
+    	resplen = http_server_append(respbuf, 0, respsize, "Number of parsed commands %4d\r\n", noc);
+    	if(result->duplicate){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Duplicate request, nothing queued again\r\n");
+    	}
+    	if(result->optimized){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Frames %4d air time %u ms -> %u ms\r\n",
+    				result->queued, result->airtime_before_us / 1000, result->airtime_after_us / 1000);
+    	}
+    	if(result->scheduled){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Scheduled %4d ids",result->scheduled);
+    		for(i = 0; i < result->scheduled && i < FRAMEDISPATCHER_REPORT_IDS; i++)
+    			resplen = http_server_append(respbuf, resplen, respsize, " %d",result->schedule_ids[i]);
+    		resplen = http_server_append(respbuf, resplen, respsize, "\r\n");
+    	}
+    	if(result->cancelled){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Cancelled %4d\r\n",result->cancelled);
+    	}
+    	if(result->suppressed){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Suppressed %4d\r\n",result->suppressed);
+    	}
+    	if(result->skipped){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Skipped %4d, command %d has no \"%s\"\r\n",
+    				result->skipped, result->skipped_index, result->skipped_field);
+    	}
+    	if(waited){
+    		resplen = http_server_append(respbuf, resplen, respsize, "Job %u %s queue wait %u ms air time %u ms repetitions %u\r\n",
+    				job->id, jobTracker_state_name(job->state),
+    				(job->state > JOB_QUEUED ? job->started - job->queued : xTaskGetTickCount() - job->queued) * portTICK_PERIOD_MS,
+    				job->airtime * portTICK_PERIOD_MS, job->repetitions);
+    	}
+    	netconn_write(conn, respbuf, resplen, NETCONN_COPY);
 
     }
 
@@ -142,22 +468,57 @@ http_server_netconn_serve(struct netconn *conn)
   netbuf_delete(inbuf);
 }
 
+/*
+ * @brief connection handler, every handler accepts on the shared listening connection
+ */
 static void http_server(void *pvParameters)
 {
-  struct netconn *conn, *newconn;
+  struct netconn *conn = (struct netconn *)pvParameters;
+  struct netconn *newconn;
+  http_server_context *ctx;
+  UBaseType_t left;
   err_t err;
-  conn = netconn_new(NETCONN_TCP);
-  netconn_bind(conn, NULL, portnumber);
-  netconn_listen(conn);
+
+  if ((ctx = calloc(1, sizeof(http_server_context))) == NULL) {
+    ESP_LOGE(SERVER_TAG, "no memory for %s", pcTaskGetTaskName(NULL));
+    vTaskDelete(NULL);
+    return;
+  }
+  ctx->stack_low = SOCKETSERVER_HANDLER_STACK;
   do {
      err = netconn_accept(conn, &newconn);
      if (err == ERR_OK) {
-       http_server_netconn_serve(newconn);
+       //a client that stops halfway through a request does not hold up the handler
+       netconn_set_recvtimeout(newconn, SOCKETSERVER_RECV_TIMEOUT_MS);
+       http_server_netconn_serve(newconn, ctx);
        netconn_delete(newconn);
+       //SOCKETSERVER_HANDLER_STACK is sized from this, a new low is worth a line in the log
+       if ((left = uxTaskGetStackHighWaterMark(NULL)) < ctx->stack_low) {
+         ctx->stack_low = left;
+         ESP_LOGI(SERVER_TAG, "%s stack high water mark %u of %u bytes", pcTaskGetTaskName(NULL), (unsigned)left, SOCKETSERVER_HANDLER_STACK);
+       }
      }
    } while(err == ERR_OK);
-   netconn_close(conn);
-   netconn_delete(conn);
+   free(ctx);
+   vTaskDelete(NULL);
+}
+
+/*
+ * @brief listen on the port and start the connection handlers, a slow request no longer holds up the others
+ */
+static void http_server_start(void)
+{
+  struct netconn *conn;
+  char name[configMAX_TASK_NAME_LEN];
+  int i;
+
+  conn = netconn_new(NETCONN_TCP);
+  netconn_bind(conn, NULL, portnumber);
+  netconn_listen(conn);
+  for (i = 0; i < SOCKETSERVER_HANDLERS; i++) {
+    snprintf(name, sizeof(name), "http_server%d", i);
+    xTaskCreatePinnedToCore((TaskFunction_t)&http_server, name, SOCKETSERVER_HANDLER_STACK, conn, 5, NULL, i % portNUM_PROCESSORS);
+  }
 }
 
 
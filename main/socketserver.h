@@ -9,6 +9,11 @@
 #define MAIN_SOCKETSERVER_H_
 #include "esp_wifi_types.h"
 
+#define SOCKETSERVER_HANDLERS		2		/*!< connection handler tasks, spread over both cores */
+#define SOCKETSERVER_HANDLER_STACK	3072	/*!< reader, cJSON recursion and logging, the response lives on the heap. Check the logged high water mark when this changes */
+#define SOCKETSERVER_REQUEST_MAX	16384	/*!< bytes of a request held while it is read */
+#define SOCKETSERVER_RECV_TIMEOUT_MS	5000	/*!< wait for the rest of a request */
+
 
 int init_socketserver(wifi_config_t * config , uint16_t portnumber);
 
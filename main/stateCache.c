@@ -0,0 +1,242 @@
+/*
+ * stateCache.c
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Last commanded value per (protocol, address, unit), recorded by the dispatcher
+ *  when the command is queued so a request compares with what is still waiting
+ *  to go out, and marked sent when its frame went on air. Lookups hash into a
+ *  small open addressed table, when the probe window is full the entry that was
+ *  commanded longest ago is replaced.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "stateCache.h"
+#include "rfProtocol.h"
+
+#define STATECACHE_MASK		(STATECACHE_ENTRIES - 1)
+
+typedef struct {
+		uint8_t protocol;
+		uint8_t unit;
+		uint8_t value;
+		uint8_t pending;			//'1' until the frame of the value went on air
+		uint32_t address;
+		TickType_t commanded;		//when the value was queued
+		TickType_t sent;			//when it went on air
+		int valid;
+}stateEntry;
+
+static stateEntry states[STATECACHE_ENTRIES];
+static portMUX_TYPE stateMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char * const policyNames[] = { "send", "skip", "shorten" };
+
+/*
+ * @brief policy id by name, STATECACHE_SEND when unknown
+ */
+int stateCache_policy(const char * name)
+{
+	int i;
+
+	for(i = 0; name != NULL && i < (int)(sizeof(policyNames) / sizeof(policyNames[0])); i++){
+		if(strcmp(name, policyNames[i]) == 0)
+			return i;
+	}
+	return STATECACHE_SEND;
+}
+
+static uint32_t stateCache_hash(int protocol, uint32_t address, int unit)
+{
+	uint32_t hash = 2166136261u;
+
+	hash = (hash ^ (uint32_t)protocol) * 16777619u;
+	hash = (hash ^ address) * 16777619u;
+	hash = (hash ^ (uint32_t)unit) * 16777619u;
+	return hash;
+}
+
+static int stateCache_match(const stateEntry * entry, int protocol, uint32_t address, int unit)
+{
+	return entry->valid && entry->address == address && entry->unit == unit && entry->protocol == protocol;
+}
+
+/*
+ * @brief slot of a unit, or of the slot to (re)use for it when find_free is set, -1 if absent
+ */
+static int stateCache_slot(int protocol, uint32_t address, int unit, int find_free)
+{
+	uint32_t hash = stateCache_hash(protocol, address, unit);
+	int oldest = -1;
+	int i;
+
+	for(i = 0; i < STATECACHE_PROBE; i++){
+		int slot = (hash + i) & STATECACHE_MASK;
+
+		if(stateCache_match(&states[slot], protocol, address, unit))
+			return slot;
+		if(!find_free)
+			continue;
+		if(!states[slot].valid)
+			return slot;
+		if(oldest < 0 || (int32_t)(states[slot].commanded - states[oldest].commanded) < 0)
+			oldest = slot;
+	}
+	return oldest;
+}
+
+static void stateCache_store(const RFcommand * command, int unit, TickType_t now)
+{
+	int slot = stateCache_slot(command->protocol, command->address, unit, 1);
+	stateEntry * entry = &states[slot];
+
+	entry->protocol = command->protocol;
+	entry->address = command->address;
+	entry->unit = unit;
+	entry->value = command->value;
+	entry->pending = 1;
+	entry->commanded = now;
+	entry->valid = 1;
+}
+
+static int stateCache_same_address(const stateEntry * entry, const RFcommand * command)
+{
+	return entry->valid && entry->address == command->address && entry->protocol == command->protocol;
+}
+
+/*
+ * @brief remember the value a command was queued with, a group command updates every known unit of its address
+ */
+void stateCache_record(const RFcommand * command, TickType_t now)
+{
+	int i;
+
+	portENTER_CRITICAL(&stateMux);
+	if(command->group){
+		for(i = 0; i < STATECACHE_ENTRIES; i++){
+			if(stateCache_same_address(&states[i], command)){
+				states[i].value = command->value;
+				states[i].pending = 1;
+				states[i].commanded = now;
+			}
+		}
+	}else{
+		stateCache_store(command, command->unit, now);
+	}
+	portEXIT_CRITICAL(&stateMux);
+}
+
+static void stateCache_mark(stateEntry * entry, const RFcommand * command, int sent, TickType_t now)
+{
+	if(!stateCache_same_address(entry, command) || entry->value != command->value)
+		return;
+	if(sent){
+		entry->pending = 0;
+		entry->sent = now;
+	}else{
+		entry->valid = 0;
+	}
+}
+
+/*
+ * @brief a command went on air, or failed to
+ *
+ * only units still commanded to its value are updated, a later command or an
+ * intermediate fade step leaves them alone. A unit whose frame failed is unknown
+ */
+void stateCache_sent(const RFcommand * command, int sent, TickType_t now)
+{
+	int slot;
+	int i;
+
+	portENTER_CRITICAL(&stateMux);
+	if(command->group){
+		for(i = 0; i < STATECACHE_ENTRIES; i++)
+			stateCache_mark(&states[i], command, sent, now);
+	}else if((slot = stateCache_slot(command->protocol, command->address, command->unit, 0)) >= 0){
+		stateCache_mark(&states[slot], command, sent, now);
+	}
+	portEXIT_CRITICAL(&stateMux);
+}
+
+/*
+ * @brief last commanded value of the unit of a command and when it was queued, returns 0 when unknown
+ */
+int stateCache_lookup(const RFcommand * command, int * value, TickType_t * commanded)
+{
+	int slot;
+
+	portENTER_CRITICAL(&stateMux);
+	slot = stateCache_slot(command->protocol, command->address, command->unit, 0);
+	if(slot >= 0){
+		*value = states[slot].value;
+		*commanded = states[slot].commanded;
+	}
+	portEXIT_CRITICAL(&stateMux);
+
+	return slot >= 0;
+}
+
+/*
+ * @brief apply a suppression policy to a command that is about to be queued
+ *
+ * before is the command queued ahead of it for the same unit in the same batch,
+ * NULL when there is none, the table does not know about that one yet. Returns 0
+ * when the command should not be sent at all, 1 otherwise; a shortened command
+ * gets its repetitions reduced in place
+ */
+int stateCache_apply(RFcommand * command, int policy, uint32_t fresh_ms, TickType_t now, const RFcommand * before)
+{
+	int value;
+	TickType_t commanded;
+
+	if(policy == STATECACHE_SEND || command->group || command->fade)
+		return 1;
+	if(before != NULL){
+		if(before->value != command->value)
+			return 1;
+	}else{
+		if(!stateCache_lookup(command, &value, &commanded) || value != command->value)
+			return 1;
+		if((now - commanded) * portTICK_PERIOD_MS > fresh_ms)
+			return 1;
+	}
+
+	if(policy == STATECACHE_SKIP)
+		return 0;
+	if(command->repetitions > STATECACHE_SHORT_REPETITIONS)
+		command->repetitions = STATECACHE_SHORT_REPETITIONS;
+	return 1;
+}
+
+/*
+ * @brief the whole table as a json array, free with cJSON_Delete
+ */
+cJSON * stateCache_to_json(TickType_t now)
+{
+	stateEntry entry;
+	cJSON * array = cJSON_CreateArray();
+	int i;
+
+	for(i = 0; array != NULL && i < STATECACHE_ENTRIES; i++){
+		cJSON * state;
+
+		portENTER_CRITICAL(&stateMux);
+		entry = states[i];
+		portEXIT_CRITICAL(&stateMux);
+
+		if(!entry.valid || (state = cJSON_CreateObject()) == NULL)
+			continue;
+		cJSON_AddStringToObject(state, "protocol", rfProtocol_name(entry.protocol));
+		cJSON_AddNumberToObject(state, "address", entry.address);
+		cJSON_AddNumberToObject(state, "unit", entry.unit);
+		cJSON_AddNumberToObject(state, "value", entry.value);
+		cJSON_AddNumberToObject(state, "age", (now - entry.commanded) * portTICK_PERIOD_MS);
+		cJSON_AddBoolToObject(state, "pending", entry.pending);
+		cJSON_AddItemToArray(array, state);
+	}
+	return array;
+}
@@ -0,0 +1,32 @@
+/*
+ * stateCache.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef MAIN_STATECACHE_H_
+#define MAIN_STATECACHE_H_
+
+#include "frameDispatcher.h"
+#include "cJSON.h"
+
+#define STATECACHE_ENTRIES				64		/*!< units remembered, must be a power of 2 */
+#define STATECACHE_PROBE				8		/*!< slots searched before the oldest is replaced */
+#define STATECACHE_FRESH_MS				60000	/*!< default window in which a state is trusted */
+#define STATECACHE_SHORT_REPETITIONS	3		/*!< repetitions of a shortened send */
+
+enum stateCachePolicies
+{
+	STATECACHE_SEND = 0,	//always send in full
+	STATECACHE_SKIP,		//drop sends that would not change the state
+	STATECACHE_SHORTEN		//send them with fewer repetitions
+};
+
+int stateCache_policy(const char * name);
+void stateCache_record(const RFcommand * command, TickType_t now);
+void stateCache_sent(const RFcommand * command, int sent, TickType_t now);
+int stateCache_lookup(const RFcommand * command, int * value, TickType_t * commanded);
+int stateCache_apply(RFcommand * command, int policy, uint32_t fresh_ms, TickType_t now, const RFcommand * before);
+cJSON * stateCache_to_json(TickType_t now);
+
+#endif /* MAIN_STATECACHE_H_ */
@@ -0,0 +1,45 @@
+/*
+ * bench.h
+ *
+ *  Clock and payloads for the host benchmarks
+ */
+
+#ifndef TEST_BENCH_H_
+#define TEST_BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_PAYLOADS	"../testJSONs/"
+
+static double bench_ns()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/*
+ * @brief contents of testJSONs/name as a 0 terminated string, NULL when it can not be read
+ */
+static inline char * bench_load(const char * name)
+{
+	char path[128];
+	char * text = NULL;
+	long size;
+	FILE * file;
+
+	snprintf(path, sizeof(path), BENCH_PAYLOADS "%s", name);
+	if((file = fopen(path, "rb")) == NULL)
+		return NULL;
+	if(fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0
+			&& (text = malloc(size + 1)) != NULL){
+		text[fread(text, 1, size, file)] = 0;
+	}
+	fclose(file);
+	return text;
+}
+
+#endif /* TEST_BENCH_H_ */
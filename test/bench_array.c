@@ -0,0 +1,58 @@
+/*
+ * bench_array.c
+ *
+ *  Walking the commands of a request of 10, 100 and 1000 commands, with the
+ *  index loop over cJSON_GetArraySize and cJSON_GetArrayItem the dispatcher used
+ *  to have and with cJSON_ArrayForEach. Built plain and indexed.
+ */
+#include <stdio.h>
+#include "cJSON.h"
+#include "bench.h"
+
+#define COMMANDS_MAX	1000
+#define WALKED			100000		/*!< commands walked per measurement */
+
+int main()
+{
+	static char json[COMMANDS_MAX * 64];
+	cJSON * root;
+	cJSON * commands;
+	cJSON * command;
+	double start, loop, foreach;
+	long sink = 0;
+	int count, used, walks, walk, i;
+
+#ifdef CJSON_OBJECT_INDEX
+	printf("array walk, indexed\n");
+#else
+	printf("array walk, plain\n");
+#endif
+	for(count = 10; count <= COMMANDS_MAX; count *= 10){
+		used = sprintf(json, "{\"commands\":[");
+		for(i = 0; i < count; i++)
+			used += sprintf(json + used, "%s{\"protocol\":\"kaku\",\"value\":1,\"unit\":%d,\"address\":1}", i ? "," : "", i % 16);
+		sprintf(json + used, "]}");
+
+		root = cJSON_Parse(json);
+		commands = cJSON_GetObjectItem(root, "commands");
+		walks = WALKED / count;
+
+		start = bench_ns();
+		for(walk = 0; walk < walks; walk++){
+			for(i = 0; i < cJSON_GetArraySize(commands); i++)
+				sink += cJSON_GetArrayItem(commands, i)->child->next->valueint;
+		}
+		loop = (bench_ns() - start) / walks;
+
+		start = bench_ns();
+		for(walk = 0; walk < walks; walk++){
+			cJSON_ArrayForEach(command, commands)
+				sink += command->child->next->valueint;
+		}
+		foreach = (bench_ns() - start) / walks;
+
+		printf("%4d commands: index loop %9.0f ns, foreach %7.0f ns\n", count, loop, foreach);
+		cJSON_Delete(root);
+	}
+	return sink == 42;
+}
@@ -0,0 +1,141 @@
+/*
+ * bench_commandStream.c
+ *
+ *  The commands of the testJSONs payloads read by the commandStream, and by
+ *  cJSON_Parse followed by the member lookups the tree path does. Reports the
+ *  time per request and the peak heap each one needs, the stream only has its
+ *  own state. Payloads the stream hands to cJSON are marked as such.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "commandStream.h"
+#include "bench.h"
+
+#define REQUESTS	20000
+#define TRACK_HEADER	16		//keeps the block aligned like malloc does
+
+static const char * const payloads[] = {
+	"rfcommands.json", "rfcommands_on.json", "rfcommands_off.json", "rfcommands_dim.json",
+	"rfcommands_optimize.json", "rfcommands_incomplete.json", "rfcommands_large.json", "rfcommands_fade.json"
+};
+
+static size_t heap_now = 0;
+static size_t heap_peak = 0;
+
+int rfProtocol_id(const char * name)
+{
+	return strcmp(name, "kaku") == 0 ? RF_PROTOCOL_KAKU : RF_PROTOCOL_UNKNOWN;
+}
+
+int frameDispatcher_type_id(const char * name)
+{
+	if(strcmp(name, "dimmer") == 0)
+		return RF_TYPE_DIMMER;
+	return strcmp(name, "switch") == 0 ? RF_TYPE_SWITCH : RF_TYPE_UNKNOWN;
+}
+
+/*
+ * @brief malloc that keeps the size in front of the block, for the peak
+ */
+static void * tracked_malloc(size_t size)
+{
+	size_t * block = malloc(TRACK_HEADER + size);
+
+	if(block == NULL)
+		return NULL;
+	*block = size;
+	if((heap_now += size) > heap_peak)
+		heap_peak = heap_now;
+	return (char *)block + TRACK_HEADER;
+}
+
+static void tracked_free(void * ptr)
+{
+	size_t * block;
+
+	if(ptr == NULL)
+		return;
+	block = (size_t *)((char *)ptr - TRACK_HEADER);
+	heap_now -= *block;
+	free(block);
+}
+
+/*
+ * @brief members of the commands the way the tree path looks them up, -1 when it does not parse
+ */
+static int tree_commands(const char * json)
+{
+	static const char * const members[] = { "protocol", "type", "value", "unit", "address", "repeat" };
+	cJSON * root = cJSON_Parse(json);
+	cJSON * command;
+	int found = 0;
+	size_t i;
+
+	if(root == NULL)
+		return -1;
+	cJSON_ArrayForEach(command, cJSON_GetObjectItem(root, "commands")){
+		for(i = 0; i < sizeof(members) / sizeof(members[0]); i++)
+			found += cJSON_GetObjectItem(command, members[i]) != NULL;
+	}
+	cJSON_Delete(root);
+	return found;
+}
+
+/*
+ * @brief commands of the request read by the stream, -1 when it hands the request to cJSON
+ */
+static int stream_commands(const char * json, size_t length)
+{
+	static const batchEntry defaults;
+	commandStream stream;
+	batchEntry entry;
+	int count = 0;
+	int result;
+
+	commandStream_init(&stream, &defaults);
+	commandStream_feed(&stream, json, length);
+	while((result = commandStream_next(&stream, &entry)) == COMMANDSTREAM_COMMAND || result == COMMANDSTREAM_SKIPPED)
+		count++;
+	return result == COMMANDSTREAM_END ? count : -1;
+}
+
+int main()
+{
+	cJSON_Hooks hooks = { tracked_malloc, tracked_free };
+	double start, tree, stream;
+	size_t length, i;
+	long sink = 0;
+	char * json;
+	int n;
+
+	cJSON_InitHooks(&hooks);
+	printf("per request: time / peak heap, the stream state is %u bytes\n", (unsigned)sizeof(commandStream));
+	for(i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++){
+		if((json = bench_load(payloads[i])) == NULL){
+			printf("%s: can not read it\n", payloads[i]);
+			return 1;
+		}
+		length = strlen(json);
+
+		heap_peak = 0;
+		start = bench_ns();
+		for(n = 0; n < REQUESTS; n++)
+			sink += tree_commands(json);
+		tree = (bench_ns() - start) / REQUESTS;
+
+		printf("%-27s %5u bytes: cJSON %6.0f ns / %5u bytes", payloads[i], (unsigned)length, tree, (unsigned)heap_peak);
+		if(stream_commands(json, length) < 0){
+			printf(", stream hands it to cJSON\n");
+		}else{
+			start = bench_ns();
+			for(n = 0; n < REQUESTS; n++)
+				sink += stream_commands(json, length);
+			stream = (bench_ns() - start) / REQUESTS;
+			printf(", stream %6.0f ns / %5u bytes\n", stream, 0u);
+		}
+		free(json);
+	}
+	return sink == 42;
+}
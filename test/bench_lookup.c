@@ -0,0 +1,59 @@
+/*
+ * bench_lookup.c
+ *
+ *  cJSON_GetObjectItem on objects of 4 to 512 members, and the first lookup on
+ *  a freshly parsed object, which with CJSON_OBJECT_INDEX also builds the index.
+ *  Built plain and indexed to compare the two.
+ */
+#include <stdio.h>
+#include "cJSON.h"
+#include "bench.h"
+
+#define MEMBERS_MAX		512
+#define LOOKUPS			2000000
+#define FRESH_TREES		2000
+
+int main()
+{
+	static char json[MEMBERS_MAX * 24];
+	char keys[MEMBERS_MAX][16];
+	cJSON * object;
+	cJSON * fresh;
+	double start, lookup, first;
+	long sink = 0;
+	int members, used, i;
+
+#ifdef CJSON_OBJECT_INDEX
+	printf("object lookup, indexed\n");
+#else
+	printf("object lookup, plain\n");
+#endif
+	for(members = 4; members <= MEMBERS_MAX; members *= 2){
+		used = sprintf(json, "{");
+		for(i = 0; i < members; i++){
+			sprintf(keys[i], "member_%d", i);
+			used += sprintf(json + used, "%s\"%s\":%d", i ? "," : "", keys[i], i);
+		}
+		sprintf(json + used, "}");
+
+		object = cJSON_Parse(json);
+		start = bench_ns();
+		for(i = 0; i < LOOKUPS; i++)
+			sink += cJSON_GetObjectItem(object, keys[(unsigned)i * 7919u % (unsigned)members])->valueint;
+		lookup = (bench_ns() - start) / LOOKUPS;
+		cJSON_Delete(object);
+
+		//a miss walks every member, indexed it also pays for the index
+		first = 0;
+		for(i = 0; i < FRESH_TREES; i++){
+			fresh = cJSON_Parse(json);
+			start = bench_ns();
+			sink += cJSON_GetObjectItem(fresh, "absent") != NULL;
+			first += bench_ns() - start;
+			cJSON_Delete(fresh);
+		}
+
+		printf("%4d members: lookup %6.1f ns, first miss %7.0f ns\n", members, lookup, first / FRESH_TREES);
+	}
+	return sink == 42;
+}
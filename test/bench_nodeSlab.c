@@ -0,0 +1,248 @@
+/*
+ * bench_nodeSlab.c
+ *
+ *  Parse and delete of a typical request with the nodes on the heap and in the
+ *  slab. Then the fragmentation: 10000 requests of the testJSONs payloads on a
+ *  96 KB first fit heap, between buffers that live for a few requests like those
+ *  of Wi-Fi and lwIP, with the nodes on that heap and in the slab. Reports the
+ *  largest free block along the way, the slab block counts as taken.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "nodeSlab.h"
+#include "bench.h"
+
+#define REQUESTS		200000
+#define FRAGMENT_REQUESTS	10000
+#define HEAP_SIZE		(96 * 1024)
+#define HEAP_ALIGN		16
+#define BUFFERS			24			//other buffers alive at once
+
+typedef struct {
+		uint32_t size;				//of the block with this header
+		uint32_t previous;			//size of the block before, 0 for the first
+		uint32_t used;
+		uint32_t pad;
+}heapBlock;
+
+static uint8_t * heap;
+static uint8_t * heap_end;
+
+static const char * const payloads[] = {
+	"rfcommands.json", "rfcommands_on.json", "rfcommands_off.json", "rfcommands_dim.json", "rfcommands_fade.json",
+	"rfcommands_wait.json", "rfcommands_async.json", "rfcommands_key.json", "rfcommands_metadata.json",
+	"rfcommands_optimize.json", "rfcommands_delayed_off.json", "rfcommands_large.json"
+};
+
+#define PAYLOADS	(int)(sizeof(payloads) / sizeof(payloads[0]))
+
+static heapBlock * heap_next(heapBlock * block)
+{
+	return (heapBlock *)((uint8_t *)block + block->size);
+}
+
+static void heap_init()
+{
+	heapBlock * block;
+
+	heap = malloc(HEAP_SIZE);
+	heap_end = heap + HEAP_SIZE;
+	block = (heapBlock *)heap;
+	block->size = HEAP_SIZE;
+	block->previous = 0;
+	block->used = 0;
+}
+
+static void * heap_malloc(size_t size)
+{
+	uint32_t needed = (sizeof(heapBlock) + size + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+	heapBlock * block;
+	heapBlock * rest;
+
+	for(block = (heapBlock *)heap; (uint8_t *)block < heap_end; block = heap_next(block)){
+		if(block->used || block->size < needed)
+			continue;
+		if(block->size - needed >= 2 * sizeof(heapBlock)){
+			rest = (heapBlock *)((uint8_t *)block + needed);
+			rest->size = block->size - needed;
+			rest->previous = needed;
+			rest->used = 0;
+			if((uint8_t *)heap_next(rest) < heap_end)
+				heap_next(rest)->previous = rest->size;
+			block->size = needed;
+		}
+		block->used = 1;
+		return block + 1;
+	}
+	return NULL;
+}
+
+static void heap_free(void * ptr)
+{
+	heapBlock * block = (heapBlock *)ptr - 1;
+	heapBlock * next;
+
+	if(ptr == NULL)
+		return;
+	block->used = 0;
+	if((uint8_t *)(next = heap_next(block)) < heap_end && !next->used)
+		block->size += next->size;
+	if(block->previous && !((heapBlock *)((uint8_t *)block - block->previous))->used){
+		uint32_t size = block->size;
+
+		block = (heapBlock *)((uint8_t *)block - block->previous);
+		block->size += size;
+	}
+	if((uint8_t *)(next = heap_next(block)) < heap_end)
+		next->previous = block->size;
+}
+
+static int heap_owns(const void * ptr)
+{
+	return (const uint8_t *)ptr >= heap && (const uint8_t *)ptr < heap_end;
+}
+
+/*
+ * @brief largest free block, total gets all free bytes
+ */
+static uint32_t heap_largest_free(uint32_t * total)
+{
+	heapBlock * block;
+	uint32_t largest = 0;
+
+	*total = 0;
+	for(block = (heapBlock *)heap; (uint8_t *)block < heap_end; block = heap_next(block)){
+		if(block->used)
+			continue;
+		*total += block->size - sizeof(heapBlock);
+		if(block->size - sizeof(heapBlock) > largest)
+			largest = block->size - sizeof(heapBlock);
+	}
+	return largest;
+}
+
+/*
+ * @brief node from the slab, what it has no room for comes from the simulated heap
+ */
+static void * slab_malloc(size_t size)
+{
+	nodeSlab_stats before, after;
+	void * node;
+
+	nodeSlab_get_stats(&before);
+	node = nodeSlab_alloc(size);
+	nodeSlab_get_stats(&after);
+	if(after.fallbacks == before.fallbacks)
+		return node;
+	free(node);
+	return heap_malloc(size);
+}
+
+static void slab_free(void * ptr)
+{
+	if(heap_owns(ptr))
+		heap_free(ptr);
+	else
+		nodeSlab_free(ptr);
+}
+
+static double parse_requests(const char * json)
+{
+	double start = bench_ns();
+	int i;
+
+	for(i = 0; i < REQUESTS; i++)
+		cJSON_Delete(cJSON_Parse(json));
+	return (bench_ns() - start) / REQUESTS;
+}
+
+/*
+ * @brief run the requests on a fresh heap and report the largest free block along the way
+ */
+static void fragment(char * const * json, int slab)
+{
+	cJSON_Hooks hooks = { heap_malloc, heap_free };
+	cJSON_Hooks nodeHooks = { slab_malloc, slab_free };
+	void * buffers[BUFFERS] = { NULL };
+	unsigned seed = 1;
+	uint32_t lowest = HEAP_SIZE;
+	uint32_t lowest_total = 0;
+	uint32_t largest, total;
+	unsigned failed = 0;
+	double sum = 0;
+	void * netbuf;
+	cJSON * root;
+	int i, b, payload;
+
+	heap_init();
+	cJSON_InitHooks(&hooks);
+	cJSON_InitNodeHooks(NULL);
+	if(slab){
+		//the slab itself is one block taken at boot
+		heap_malloc(NODESLAB_NODES * ((sizeof(cJSON) + 7) & ~(size_t)7));
+		cJSON_InitNodeHooks(&nodeHooks);
+	}
+
+	for(i = 0; i < FRAGMENT_REQUESTS; i++){
+		//mostly small requests, now and then a large scene
+		payload = rand_r(&seed) % (4 * PAYLOADS);
+		payload = payload < 3 * PAYLOADS ? payload % (PAYLOADS - 1) : payload % PAYLOADS;
+
+		netbuf = heap_malloc(strlen(json[payload]) + 64);
+		if((root = cJSON_Parse(json[payload])) == NULL)
+			failed++;
+		//a buffer of the network stack comes and goes while the tree is alive
+		b = rand_r(&seed) % BUFFERS;
+		heap_free(buffers[b]);
+		buffers[b] = heap_malloc(64 + rand_r(&seed) % 1536);
+		cJSON_Delete(root);
+		heap_free(netbuf);
+
+		sum += largest = heap_largest_free(&total);
+		if(largest < lowest){
+			lowest = largest;
+			lowest_total = total;
+		}
+	}
+	printf("  %s nodes: mean %6.0f bytes, lowest %6u bytes of %6u free, %u requests failed\n",
+			slab ? "slab" : "heap", sum / FRAGMENT_REQUESTS, lowest, lowest_total, failed);
+
+	for(b = 0; b < BUFFERS; b++)
+		heap_free(buffers[b]);
+	cJSON_InitNodeHooks(NULL);
+	cJSON_InitHooks(NULL);
+	free(heap);
+}
+
+int main()
+{
+	const char * json = "{\"commands\":[{\"protocol\":\"kaku\",\"type\":\"dimmer\",\"address\":123,\"unit\":1,\"value\":8},"
+			"{\"protocol\":\"kaku\",\"type\":\"switch\",\"address\":123,\"unit\":2,\"value\":1,\"delay\":500}],\"wait\":true}";
+	cJSON_Hooks hooks = { nodeSlab_alloc, nodeSlab_free };
+	char * requests[PAYLOADS];
+	double heap_ns;
+	int i;
+
+	for(i = 0; i < PAYLOADS; i++){
+		if((requests[i] = bench_load(payloads[i])) == NULL){
+			printf("%s: can not read it\n", payloads[i]);
+			return 1;
+		}
+	}
+
+	//once the slab is set up it stays, so the heap runs go first
+	heap_ns = parse_requests(json);
+	printf("%d requests on a %d KB heap, largest free block after each\n", FRAGMENT_REQUESTS, HEAP_SIZE / 1024);
+	fragment(requests, 0);
+	nodeSlab_init(sizeof(cJSON), NODESLAB_NODES);
+	fragment(requests, 1);
+
+	cJSON_InitNodeHooks(&hooks);
+	printf("request parse and delete: heap nodes %.0f ns, slab nodes %.0f ns\n", heap_ns, parse_requests(json));
+
+	for(i = 0; i < PAYLOADS; i++)
+		free(requests[i]);
+	return 0;
+}
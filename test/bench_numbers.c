@@ -0,0 +1,111 @@
+/*
+ * bench_numbers.c
+ *
+ *  cJSON_Parse of number heavy payloads: an array of integers and the large
+ *  command request. Each is parsed as written, where the integers take the
+ *  integer fast path, and with ".0" after every integer, which sends the same
+ *  values through strtod. Built plain and with CJSON_INT_ONLY. The host has a
+ *  double FPU, on the ESP32 strtod is soft float and costs more.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "bench.h"
+
+#define INTEGERS	1000
+#define REQUESTS	5000
+
+/*
+ * @brief copy of json with ".0" after every number outside a string that has no fraction or exponent
+ */
+static char * with_fraction(const char * json)
+{
+	char * copy = malloc(strlen(json) * 3 + 1);
+	char * out = copy;
+	int in_string = 0;
+
+	while(*json){
+		if(in_string){
+			if(*json == '\\' && json[1])
+				*out++ = *json++;
+			else if(*json == '"')
+				in_string = 0;
+			*out++ = *json++;
+		}else if(*json == '"'){
+			in_string = 1;
+			*out++ = *json++;
+		}else if(*json >= '0' && *json <= '9'){
+			while(*json >= '0' && *json <= '9')
+				*out++ = *json++;
+			if(*json != '.' && *json != 'e' && *json != 'E'){
+				*out++ = '.';
+				*out++ = '0';
+			}
+		}else{
+			*out++ = *json++;
+		}
+	}
+	*out = 0;
+	return copy;
+}
+
+static int count_numbers(const cJSON * item)
+{
+	int count = cJSON_IsNumber(item);
+
+	for(item = item->child; item != NULL; item = item->next)
+		count += count_numbers(item);
+	return count;
+}
+
+static void run(const char * name, const char * json)
+{
+	char * fraction = with_fraction(json);
+	cJSON * root = cJSON_Parse(json);
+	double start, integer, strtod_path;
+	int numbers, i;
+
+	numbers = count_numbers(root);
+	cJSON_Delete(root);
+
+	start = bench_ns();
+	for(i = 0; i < REQUESTS; i++)
+		cJSON_Delete(cJSON_Parse(json));
+	integer = (bench_ns() - start) / REQUESTS;
+
+	start = bench_ns();
+	for(i = 0; i < REQUESTS; i++)
+		cJSON_Delete(cJSON_Parse(fraction));
+	strtod_path = (bench_ns() - start) / REQUESTS;
+
+	printf("%-22s %4d numbers: integers %7.0f ns, with \".0\" %7.0f ns per request\n", name, numbers, integer, strtod_path);
+	free(fraction);
+}
+
+int main()
+{
+	static char array[INTEGERS * 12 + 2];
+	char * large;
+	int used, i;
+
+#ifdef CJSON_INT_ONLY
+	printf("number parsing, integer only build\n");
+#else
+	printf("number parsing\n");
+#endif
+	//sizes like addresses, units, values and delays
+	used = sprintf(array, "[");
+	for(i = 0; i < INTEGERS; i++)
+		used += sprintf(array + used, "%s%d", i ? "," : "", (i % 4 == 0) ? 21036234 + i : (i % 4 == 1) ? i % 16 : (i % 4 == 2) ? i % 256 : 600000);
+	sprintf(array + used, "]");
+	run("array of integers", array);
+
+	if((large = bench_load("rfcommands_large.json")) == NULL){
+		printf("rfcommands_large.json: can not read it\n");
+		return 1;
+	}
+	run("rfcommands_large.json", large);
+	free(large);
+	return 0;
+}
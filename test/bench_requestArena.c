@@ -0,0 +1,115 @@
+/*
+ * bench_requestArena.c
+ *
+ *  Parse and delete of the testJSONs payloads with every cJSON allocation on
+ *  the heap, with the strings and nodes in the request arena, and with the
+ *  strings in the arena and the nodes in the slab like the firmware does.
+ *  Reports the heap allocations and the time per request. On the host the
+ *  critical section of the slab is a pthread mutex, which makes the slab look
+ *  slower than it is on the device.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "requestArena.h"
+#include "nodeSlab.h"
+#include "bench.h"
+
+#define REQUESTS	20000
+
+static const char * const payloads[] = {
+	"rfcommands.json", "rfcommands_on.json", "rfcommands_dim.json", "rfcommands_fade.json",
+	"rfcommands_metadata.json", "rfcommands_optimize.json", "rfcommands_large.json"
+};
+
+#define PAYLOADS	(int)(sizeof(payloads) / sizeof(payloads[0]))
+
+enum arenaModes
+{
+	MODE_HEAP = 0,
+	MODE_ARENA,
+	MODE_ARENA_SLAB,
+	MODES
+};
+
+static unsigned long heap_allocations = 0;
+
+static void * counted_malloc(size_t size)
+{
+	heap_allocations++;
+	return malloc(size);
+}
+
+/*
+ * @brief ns per request, allocations gets the heap allocations per request
+ */
+static double parse_requests(const char * json, int mode, double * allocations)
+{
+	nodeSlab_stats before, after;
+	requestArena arena;
+	size_t length = strlen(json);
+	unsigned long overflows = 0;
+	double start;
+	int i;
+
+	heap_allocations = 0;
+	nodeSlab_get_stats(&before);
+
+	start = bench_ns();
+	for(i = 0; i < REQUESTS; i++){
+		if(mode != MODE_HEAP)
+			requestArena_begin(&arena, length);
+		cJSON_Delete(cJSON_Parse(json));
+		if(mode != MODE_HEAP){
+			overflows += arena.overflows;
+			requestArena_end(&arena);
+		}
+	}
+	start = (bench_ns() - start) / REQUESTS;
+
+	//the arena block, what did not fit in it, and the nodes the slab had no room for
+	nodeSlab_get_stats(&after);
+	if(mode != MODE_HEAP)
+		heap_allocations = REQUESTS + overflows + after.fallbacks - before.fallbacks;
+	*allocations = (double)heap_allocations / REQUESTS;
+	return start;
+}
+
+int main()
+{
+	const char * names[MODES] = { "heap", "arena", "arena+slab" };
+	cJSON_Hooks heap = { counted_malloc, free };
+	double ns[PAYLOADS][MODES];
+	double allocations[PAYLOADS][MODES];
+	char * json[PAYLOADS];
+	int i, mode;
+
+	for(i = 0; i < PAYLOADS; i++){
+		if((json[i] = bench_load(payloads[i])) == NULL){
+			printf("%s: can not read it\n", payloads[i]);
+			return 1;
+		}
+	}
+
+	//the slab is set up once, like at boot, so the heap runs go first
+	cJSON_InitHooks(&heap);
+	for(i = 0; i < PAYLOADS; i++)
+		ns[i][MODE_HEAP] = parse_requests(json[i], MODE_HEAP, &allocations[i][MODE_HEAP]);
+	requestArena_init();
+	for(i = 0; i < PAYLOADS; i++)
+		ns[i][MODE_ARENA_SLAB] = parse_requests(json[i], MODE_ARENA_SLAB, &allocations[i][MODE_ARENA_SLAB]);
+	cJSON_InitNodeHooks(NULL);
+	for(i = 0; i < PAYLOADS; i++)
+		ns[i][MODE_ARENA] = parse_requests(json[i], MODE_ARENA, &allocations[i][MODE_ARENA]);
+
+	printf("per request: heap allocations / parse and delete time\n");
+	for(i = 0; i < PAYLOADS; i++){
+		printf("%-25s %5u bytes:", payloads[i], (unsigned)strlen(json[i]));
+		for(mode = 0; mode < MODES; mode++)
+			printf("  %s %5.1f / %5.0f ns", names[mode], allocations[i][mode], ns[i][mode]);
+		printf("\n");
+		free(json[i]);
+	}
+	return 0;
+}
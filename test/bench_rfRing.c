@@ -0,0 +1,121 @@
+/*
+ * bench_rfRing.c
+ *
+ *  A producer thread hands batches of commands to a consumer thread, once
+ *  through the ring the way frameDispatcher_submit does and once through a
+ *  queue, one send per command like before the ring. Reports commands per
+ *  second and how often the consumer had to be woken per batch, with a consumer
+ *  that only takes the commands and with one that spends some time on each.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "hostRTOS.h"
+#include "rfRing.h"
+#include "bench.h"
+
+#define DEPTH		32			//KAKU_WORKER_DEPTH
+#define BATCH		8			//commands of a scene
+#define BATCHES		100000
+#define COMMANDS	(BATCH * BATCHES)
+
+typedef struct {
+		int use_ring;
+		int work_ns;			//time the consumer spends on each command
+		rfRing ring;
+		QueueHandle_t queue;
+		volatile int attached;
+		uint32_t received;
+		uint32_t sum;
+}bench_channel;
+
+static void busy(int ns)
+{
+	double until = bench_ns() + ns;
+
+	while(ns > 0 && bench_ns() < until);
+}
+
+static void * consumer(void * arg)
+{
+	bench_channel * channel = arg;
+	RFcommand command;
+
+	rfRing_attach(&channel->ring, xTaskGetCurrentTaskHandle());
+	__sync_synchronize();
+	channel->attached = 1;
+
+	while(channel->received < COMMANDS){
+		//the worker loop of frameDispatcher
+		if(channel->use_ring){
+			while(!rfRing_pop(&channel->ring, &command))
+				ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		}else{
+			xQueueGenericReceive(channel->queue, &command, portMAX_DELAY, pdFALSE);
+		}
+		channel->sum += command.address;
+		channel->received++;
+		busy(channel->work_ns);
+	}
+	return NULL;
+}
+
+static void producer(bench_channel * channel)
+{
+	RFcommand command = { .protocol = RF_PROTOCOL_KAKU, .type = RF_TYPE_SWITCH, .unit = 1, .value = 1 };
+	int batch, i;
+
+	for(batch = 0; batch < BATCHES; batch++){
+		if(channel->use_ring){
+			//a full ring is a 503 on the device, here the producer waits its turn
+			while(!rfRing_reserve(&channel->ring, BATCH))
+				sched_yield();
+			for(i = 0; i < BATCH; i++){
+				command.address = batch + i;
+				rfRing_stage(&channel->ring, &command);
+			}
+			rfRing_publish(&channel->ring);
+		}else{
+			for(i = 0; i < BATCH; i++){
+				command.address = batch + i;
+				xQueueGenericSend(channel->queue, &command, portMAX_DELAY, queueSEND_TO_BACK);
+			}
+		}
+	}
+}
+
+static void run(int use_ring, int work_ns)
+{
+	bench_channel channel = { .use_ring = use_ring, .work_ns = work_ns };
+	pthread_t thread;
+	double start, elapsed;
+	uint32_t wakeups;
+
+	rfRing_init(&channel.ring, DEPTH);
+	channel.queue = xQueueCreate(DEPTH, sizeof(RFcommand));
+	pthread_create(&thread, NULL, consumer, &channel);
+	while(!channel.attached)
+		sched_yield();
+
+	wakeups = hostRTOS_wakeups;
+	start = bench_ns();
+	producer(&channel);
+	pthread_join(thread, NULL);
+	elapsed = bench_ns() - start;
+	wakeups = hostRTOS_wakeups - wakeups;
+
+	printf("%s, consumer %4d ns per command: %6.2f M commands/s, %5.2f wakeups per batch\n",
+			use_ring ? "ring " : "queue", work_ns, COMMANDS / elapsed * 1e3, (double)wakeups / BATCHES);
+	free(channel.ring.items);
+}
+
+int main()
+{
+	printf("batches of %d commands through %d slots\n", BATCH, DEPTH);
+	run(0, 0);
+	run(1, 0);
+	run(0, 500);
+	run(1, 500);
+	return 0;
+}
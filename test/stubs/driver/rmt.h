@@ -0,0 +1,16 @@
+/*
+ * rmt.h
+ *
+ *  Host stand-in, only the item type the protocol operations are declared with
+ */
+
+#ifndef TEST_STUBS_RMT_H_
+#define TEST_STUBS_RMT_H_
+
+#include <stdint.h>
+
+typedef struct {
+		uint32_t val;
+}rmt_item32_t;
+
+#endif /* TEST_STUBS_RMT_H_ */
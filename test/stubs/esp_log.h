@@ -0,0 +1,28 @@
+/*
+ * esp_log.h
+ *
+ *  Host stand-in, only errors are printed so test output stays readable
+ */
+
+#ifndef TEST_STUBS_ESP_LOG_H_
+#define TEST_STUBS_ESP_LOG_H_
+
+#include <stdio.h>
+
+typedef enum {
+	ESP_LOG_NONE,
+	ESP_LOG_ERROR,
+	ESP_LOG_WARN,
+	ESP_LOG_INFO,
+	ESP_LOG_DEBUG,
+	ESP_LOG_VERBOSE
+}esp_log_level_t;
+
+#define esp_log_level_set(tag, level)	((void)(tag), (void)(level))
+
+#define ESP_LOGE(tag, format, ...)	printf("E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)	do{ if(0) printf("%s" format, tag, ##__VA_ARGS__); }while(0)
+#define ESP_LOGI(tag, format, ...)	do{ if(0) printf("%s" format, tag, ##__VA_ARGS__); }while(0)
+#define ESP_LOGD(tag, format, ...)	do{ if(0) printf("%s" format, tag, ##__VA_ARGS__); }while(0)
+
+#endif /* TEST_STUBS_ESP_LOG_H_ */
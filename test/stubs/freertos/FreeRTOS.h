@@ -0,0 +1,38 @@
+/*
+ * FreeRTOS.h
+ *
+ *  Host stand-in for the parts of FreeRTOS the tested modules use, see hostRTOS.c
+ */
+
+#ifndef TEST_STUBS_FREERTOS_H_
+#define TEST_STUBS_FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY			((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS		10
+#define portTICK_RATE_MS		portTICK_PERIOD_MS
+#define configTICK_RATE_HZ		(1000 / portTICK_PERIOD_MS)
+#define pdTRUE					1
+#define pdFALSE					0
+#define pdPASS					pdTRUE
+#define pdFAIL					pdFALSE
+#define errQUEUE_FULL			0
+
+//critical sections of all muxes share one host mutex, the mux counts its nesting
+typedef struct {
+		int depth;
+}portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED	{ 0 }
+
+void portENTER_CRITICAL(portMUX_TYPE * mux);
+void portEXIT_CRITICAL(portMUX_TYPE * mux);
+void vPortCPUInitializeMutex(portMUX_TYPE * mux);
+
+#endif /* TEST_STUBS_FREERTOS_H_ */
@@ -0,0 +1,23 @@
+/*
+ * queue.h
+ *
+ *  Host stand-in, a bounded queue on a mutex and two conditions, see hostRTOS.c
+ */
+
+#ifndef TEST_STUBS_QUEUE_H_
+#define TEST_STUBS_QUEUE_H_
+
+#include "freertos/FreeRTOS.h"
+
+#define queueSEND_TO_BACK		0
+#define queueSEND_TO_FRONT		1
+
+typedef struct QueueDefinition * QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t depth, UBaseType_t size);
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void * item, TickType_t wait, BaseType_t position);
+BaseType_t xQueueGenericReceive(QueueHandle_t queue, void * item, TickType_t wait, BaseType_t peek);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+
+#endif /* TEST_STUBS_QUEUE_H_ */
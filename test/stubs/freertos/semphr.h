@@ -0,0 +1,18 @@
+/*
+ * semphr.h
+ *
+ *  Host stand-in, a mutex is a pthread mutex
+ */
+
+#ifndef TEST_STUBS_SEMPHR_H_
+#define TEST_STUBS_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef void * SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif /* TEST_STUBS_SEMPHR_H_ */
@@ -0,0 +1,23 @@
+/*
+ * task.h
+ *
+ *  Host stand-in, the tick count is set by the test, every thread is a task
+ */
+
+#ifndef TEST_STUBS_TASK_H_
+#define TEST_STUBS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+#define HOSTRTOS_TLS_POINTERS	4
+
+typedef void * TaskHandle_t;
+
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+void * pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index);
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void * value);
+
+#endif /* TEST_STUBS_TASK_H_ */
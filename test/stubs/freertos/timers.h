@@ -0,0 +1,18 @@
+/*
+ * timers.h
+ *
+ *  Host stand-in, one software timer whose callback the test runs by hand
+ */
+
+#ifndef TEST_STUBS_TIMERS_H_
+#define TEST_STUBS_TIMERS_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef void * TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char * name, TickType_t period, UBaseType_t reload, void * id, TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait);
+
+#endif /* TEST_STUBS_TIMERS_H_ */
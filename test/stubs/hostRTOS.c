@@ -0,0 +1,283 @@
+/*
+ * hostRTOS.c
+ *
+ *  Stand-in for the FreeRTOS calls of the tested modules, on pthreads. Time only
+ *  moves when a test sets hostRTOS_ticks and the one software timer fires when a
+ *  test says so. Every thread is a task with its own notification count and
+ *  thread local storage, critical sections share one recursive mutex and check
+ *  that they are balanced. Blocking calls wait on the wall clock, one tick is
+ *  portTICK_PERIOD_MS.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "hostRTOS.h"
+
+typedef struct {
+		pthread_mutex_t lock;
+		pthread_cond_t notify;
+		uint32_t notified;
+		void * storage[HOSTRTOS_TLS_POINTERS];
+}hostTask;
+
+struct QueueDefinition {
+		pthread_mutex_t lock;
+		pthread_cond_t filled;		//an item was sent
+		pthread_cond_t drained;		//an item was received
+		uint8_t * items;
+		UBaseType_t depth;
+		UBaseType_t size;
+		UBaseType_t head;
+		UBaseType_t count;
+};
+
+TickType_t hostRTOS_ticks = 0;
+uint32_t hostRTOS_notifications = 0;
+uint32_t hostRTOS_wakeups = 0;
+__thread int hostRTOS_critical = 0;
+
+static __thread hostTask self = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, { NULL } };
+static pthread_mutex_t critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static TimerCallbackFunction_t timerCallback = NULL;
+static int timerArmed = 0;
+static int timerHandle;
+
+/*
+ * @brief absolute time wait ticks from now
+ */
+static struct timespec hostRTOS_deadline(TickType_t wait)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += wait / configTICK_RATE_HZ;
+	deadline.tv_nsec += (long)(wait % configTICK_RATE_HZ) * portTICK_PERIOD_MS * 1000000L;
+	if(deadline.tv_nsec >= 1000000000L){
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	return deadline;
+}
+
+/*
+ * @brief wait on condition with lock held, returns 0 once wait ticks passed
+ */
+static int hostRTOS_block(pthread_cond_t * condition, pthread_mutex_t * lock, const struct timespec * deadline, TickType_t wait)
+{
+	if(wait == 0)
+		return 0;
+	if(wait == portMAX_DELAY)
+		return pthread_cond_wait(condition, lock) == 0;
+	return pthread_cond_timedwait(condition, lock, deadline) != ETIMEDOUT;
+}
+
+void portENTER_CRITICAL(portMUX_TYPE * mux)
+{
+	pthread_mutex_lock(&critical);
+	mux->depth++;
+	hostRTOS_critical++;
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE * mux)
+{
+	if(mux->depth <= 0 || hostRTOS_critical <= 0){
+		printf("critical section left that was not entered\n");
+		abort();
+	}
+	mux->depth--;
+	hostRTOS_critical--;
+	pthread_mutex_unlock(&critical);
+}
+
+void vPortCPUInitializeMutex(portMUX_TYPE * mux)
+{
+	mux->depth = 0;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return hostRTOS_ticks;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return &self;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+	hostTask * to = (hostTask *) task;
+
+	__sync_fetch_and_add(&hostRTOS_notifications, 1);
+	pthread_mutex_lock(&to->lock);
+	to->notified++;
+	pthread_cond_signal(&to->notify);
+	pthread_mutex_unlock(&to->lock);
+	return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+	struct timespec deadline = hostRTOS_deadline(wait);
+	uint32_t value;
+	int blocked = 0;
+
+	pthread_mutex_lock(&self.lock);
+	while(self.notified == 0 && hostRTOS_block(&self.notify, &self.lock, &deadline, wait))
+		blocked = 1;
+	if((value = self.notified) != 0){
+		self.notified = clear ? 0 : value - 1;
+		if(blocked)
+			__sync_fetch_and_add(&hostRTOS_wakeups, 1);
+	}
+	pthread_mutex_unlock(&self.lock);
+	return value;
+}
+
+void * pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index)
+{
+	return ((hostTask *) (task ? task : &self))->storage[index];
+}
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void * value)
+{
+	((hostTask *) (task ? task : &self))->storage[index] = value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t depth, UBaseType_t size)
+{
+	QueueHandle_t queue = calloc(1, sizeof(struct QueueDefinition));
+
+	if(queue == NULL || (queue->items = malloc(depth * size)) == NULL){
+		free(queue);
+		return NULL;
+	}
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->filled, NULL);
+	pthread_cond_init(&queue->drained, NULL);
+	queue->depth = depth;
+	queue->size = size;
+	return queue;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void * item, TickType_t wait, BaseType_t position)
+{
+	struct timespec deadline = hostRTOS_deadline(wait);
+	UBaseType_t slot;
+
+	pthread_mutex_lock(&queue->lock);
+	while(queue->count == queue->depth){
+		if(!hostRTOS_block(&queue->drained, &queue->lock, &deadline, wait)){
+			pthread_mutex_unlock(&queue->lock);
+			return errQUEUE_FULL;
+		}
+	}
+	if(position == queueSEND_TO_FRONT){
+		queue->head = (queue->head + queue->depth - 1) % queue->depth;
+		slot = queue->head;
+	}else{
+		slot = (queue->head + queue->count) % queue->depth;
+	}
+	memcpy(queue->items + slot * queue->size, item, queue->size);
+	queue->count++;
+	pthread_cond_signal(&queue->filled);
+	pthread_mutex_unlock(&queue->lock);
+	return pdPASS;
+}
+
+BaseType_t xQueueGenericReceive(QueueHandle_t queue, void * item, TickType_t wait, BaseType_t peek)
+{
+	struct timespec deadline = hostRTOS_deadline(wait);
+	int blocked = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	while(queue->count == 0){
+		if(!hostRTOS_block(&queue->filled, &queue->lock, &deadline, wait)){
+			pthread_mutex_unlock(&queue->lock);
+			return pdFALSE;
+		}
+		blocked = 1;
+	}
+	memcpy(item, queue->items + queue->head * queue->size, queue->size);
+	if(!peek){
+		queue->head = (queue->head + 1) % queue->depth;
+		queue->count--;
+		pthread_cond_signal(&queue->drained);
+	}
+	pthread_mutex_unlock(&queue->lock);
+	if(blocked)
+		__sync_fetch_and_add(&hostRTOS_wakeups, 1);
+	return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+	UBaseType_t count;
+
+	pthread_mutex_lock(&queue->lock);
+	count = queue->count;
+	pthread_mutex_unlock(&queue->lock);
+	return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+	return queue->depth - uxQueueMessagesWaiting(queue);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	pthread_mutex_t * mutex = malloc(sizeof(pthread_mutex_t));
+
+	if(mutex != NULL)
+		pthread_mutex_init(mutex, NULL);
+	return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait)
+{
+	if(wait == 0)
+		return pthread_mutex_trylock(semaphore) == 0;
+	return pthread_mutex_lock(semaphore) == 0;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+	return pthread_mutex_unlock(semaphore) == 0;
+}
+
+TimerHandle_t xTimerCreate(const char * name, TickType_t period, UBaseType_t reload, void * id, TimerCallbackFunction_t callback)
+{
+	timerCallback = callback;
+	timerArmed = 0;
+	return &timerHandle;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait)
+{
+	timerArmed = 1;
+	return pdPASS;
+}
+
+/*
+ * @brief 1 when the timer was started and has not fired since
+ */
+int hostRTOS_timer_armed()
+{
+	return timerArmed;
+}
+
+/*
+ * @brief expire the timer, its callback runs like it would in the timer task
+ */
+void hostRTOS_timer_fire()
+{
+	timerArmed = 0;
+	if(timerCallback != NULL)
+		timerCallback(&timerHandle);
+}
@@ -0,0 +1,24 @@
+/*
+ * hostRTOS.h
+ *
+ *  Controls of the FreeRTOS stand-in for the tests
+ */
+
+#ifndef TEST_STUBS_HOSTRTOS_H_
+#define TEST_STUBS_HOSTRTOS_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+extern TickType_t hostRTOS_ticks;			//what xTaskGetTickCount returns
+extern uint32_t hostRTOS_notifications;		//xTaskNotifyGive calls
+extern uint32_t hostRTOS_wakeups;			//blocked tasks woken by a notification or a queue item
+extern __thread int hostRTOS_critical;		//critical sections the calling thread entered and not yet left
+
+int hostRTOS_timer_armed();
+void hostRTOS_timer_fire();
+
+#endif /* TEST_STUBS_HOSTRTOS_H_ */
@@ -0,0 +1,13 @@
+/*
+ * sdkconfig.h
+ *
+ *  Host stand-in for the configuration values the tested modules check
+ */
+
+#ifndef TEST_STUBS_SDKCONFIG_H_
+#define TEST_STUBS_SDKCONFIG_H_
+
+#define CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS	2
+#define CONFIG_LWIP_THREAD_LOCAL_STORAGE_INDEX			0
+
+#endif /* TEST_STUBS_SDKCONFIG_H_ */
@@ -0,0 +1,27 @@
+/*
+ * test.h
+ *
+ *  Checks for the host tests, a failed check is reported and counted and the
+ *  test goes on. TEST_DONE ends main with the number of failures.
+ */
+
+#ifndef TEST_TEST_H_
+#define TEST_TEST_H_
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(condition) do{ \
+		if(!(condition)){ \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			test_failures++; \
+		} \
+	}while(0)
+
+#define TEST_DONE() do{ \
+		printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "ok"); \
+		return test_failures != 0; \
+	}while(0)
+
+#endif /* TEST_TEST_H_ */
@@ -0,0 +1,222 @@
+/*
+ * test_cJSON.c
+ *
+ *  Lookups, the member index, references, filtered and in situ parsing, the
+ *  nesting limit and numbers. Built once plain, once with CJSON_OBJECT_INDEX and
+ *  once with CJSON_OBJECT_INDEX and CJSON_INT_ONLY.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "test.h"
+
+static const char * const keep[] = { "commands", "Wait", NULL };
+
+static cJSON * parse_filtered(const char * json)
+{
+	return cJSON_ParseFilteredOpts(json, strlen(json), keep, NULL, 1);
+}
+
+/*
+ * @brief "[[...[1]...]]" nested depth deep, returned buffer is static
+ */
+static const char * nested(int depth)
+{
+	static char json[2 * CJSON_NESTING_LIMIT + 16];
+	int i;
+
+	for(i = 0; i < depth; i++)
+		json[i] = '[';
+	json[depth] = '1';
+	for(i = 0; i < depth; i++)
+		json[depth + 1 + i] = ']';
+	json[2 * depth + 1] = 0;
+	return json;
+}
+
+static void test_object_lookup()
+{
+	cJSON * object = cJSON_Parse("{\"a\":1,\"B\":2,\"b\":3,\"k0\":0,\"k1\":1,\"k2\":2,\"k3\":3,\"k4\":4,"
+			"\"k5\":5,\"k6\":6,\"k7\":7,\"k8\":8,\"k9\":9,\"k10\":10,\"K10\":99}");
+	cJSON * copy;
+	int pass;
+
+	CHECK(object != NULL);
+	//the second pass goes through the index when there is one
+	for(pass = 0; pass < 2; pass++){
+		CHECK(cJSON_GetObjectItem(object, "absent") == NULL);
+		CHECK(cJSON_GetObjectItem(object, "b")->valueint == 2);
+		CHECK(cJSON_GetObjectItemCaseSensitive(object, "b")->valueint == 3);
+		CHECK(cJSON_GetObjectItem(object, "K10")->valueint == 10);
+		CHECK(cJSON_GetObjectItemCaseSensitive(object, "K10")->valueint == 99);
+	}
+#ifdef CJSON_OBJECT_INDEX
+	CHECK(object->index != NULL);
+#endif
+
+	//every mutator drops the index
+	cJSON_AddNumberToObject(object, "new", 5);
+	CHECK(cJSON_GetObjectItem(object, "NEW") != NULL);
+	cJSON_DeleteItemFromObject(object, "new");
+	CHECK(cJSON_GetObjectItem(object, "new") == NULL);
+	cJSON_ReplaceItemInObject(object, "a", cJSON_CreateNumber(7));
+	CHECK(cJSON_GetObjectItem(object, "A")->valueint == 7);
+
+	copy = cJSON_Duplicate(object, 1);
+	CHECK(cJSON_GetObjectItem(copy, "k9")->valueint == 9);
+	cJSON_Delete(copy);
+	cJSON_Delete(object);
+}
+
+static void test_array_access()
+{
+	cJSON * array = cJSON_CreateArray();
+	cJSON * element;
+	int i = 0;
+
+	for(i = 0; i < 20; i++)
+		cJSON_AddItemToArray(array, cJSON_CreateNumber(i));
+	CHECK(cJSON_GetArrayItem(array, 15)->valueint == 15);
+	CHECK(cJSON_GetArrayItem(array, 3)->valueint == 3);
+	CHECK(cJSON_GetArrayItem(array, 20) == NULL);
+	CHECK(cJSON_GetArraySize(array) == 20);
+
+	cJSON_DeleteItemFromArray(array, 0);
+	CHECK(cJSON_GetArrayItem(array, 15)->valueint == 16);
+	CHECK(cJSON_GetArraySize(array) == 19);
+	cJSON_InsertItemInArray(array, 0, cJSON_CreateNumber(100));
+	CHECK(cJSON_GetArrayItem(array, 0)->valueint == 100);
+	CHECK(cJSON_GetArrayItem(array, 19)->valueint == 19);
+	CHECK(cJSON_GetObjectItem(array, "x") == NULL);
+
+	i = 0;
+	cJSON_ArrayForEach(element, array)
+		i++;
+	CHECK(i == 20);
+	cJSON_Delete(array);
+}
+
+static void test_references()
+{
+	cJSON * object = cJSON_Parse("{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9}");
+	cJSON * array = cJSON_CreateArray();
+
+	//builds the index of object before the reference copies it
+	CHECK(cJSON_GetObjectItem(object, "e")->valueint == 5);
+	cJSON_AddItemReferenceToArray(array, object);
+	CHECK(cJSON_GetObjectItem(cJSON_GetArrayItem(array, 0), "h")->valueint == 8);
+	cJSON_Delete(array);
+	CHECK(cJSON_GetObjectItem(object, "h")->valueint == 8);
+	cJSON_Delete(object);
+}
+
+static void test_filtered()
+{
+	const char * valid[] = {
+		"{\"meta\":{\"a\":[1,2.5e-3,-0,\"x\\u00e9\\n\",true,false,null,{}],\"b\":[]},\"commands\":[{\"protocol\":\"kaku\"}],\"WAIT\":true,\"ui\":\"s\"}",
+		"{}",
+		"{\"x\":1}",
+		"[{\"meta\":1}]",
+		"{\"a\\u0062\":1,\"commands\":2}"
+	};
+	const char * invalid[] = {
+		"{\"meta\":[1,],\"commands\":1}",
+		"{\"meta\":01x,\"commands\":1}",
+		"{\"meta\":\"\\q\"}",
+		"{\"meta\":{\"a\" 1}}",
+		"{\"meta\":tru}",
+		"{\"meta\":\"abc",
+		"{\"meta\":[1 2]}",
+		"{\"meta\":\"\\u12G4\"}"
+	};
+	char buffer[256];
+	cJSON * root;
+	size_t i;
+
+	for(i = 0; i < sizeof(valid) / sizeof(valid[0]); i++){
+		root = parse_filtered(valid[i]);
+		CHECK(root != NULL);
+		cJSON_Delete(root);
+	}
+	for(i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++){
+		root = parse_filtered(invalid[i]);
+		CHECK(root == NULL);
+		cJSON_Delete(root);
+	}
+
+	//only the kept members of the top level object are in the tree
+	root = parse_filtered(valid[0]);
+	CHECK(cJSON_GetObjectItem(root, "meta") == NULL);
+	CHECK(cJSON_GetObjectItem(root, "ui") == NULL);
+	CHECK(cJSON_IsArray(cJSON_GetObjectItem(root, "commands")));
+	CHECK(cJSON_IsTrue(cJSON_GetObjectItem(root, "wait")));
+	cJSON_Delete(root);
+
+	//in situ the strings point into the request
+	strcpy(buffer, valid[0]);
+	root = cJSON_ParseInSituFilteredOpts(buffer, strlen(buffer), keep, NULL, 0);
+	CHECK(root != NULL);
+	CHECK(strcmp(cJSON_GetObjectItem(cJSON_GetArrayItem(cJSON_GetObjectItem(root, "commands"), 0), "protocol")->valuestring, "kaku") == 0);
+	cJSON_Delete(root);
+}
+
+static void test_nesting()
+{
+	char json[2 * CJSON_NESTING_LIMIT + 32];
+	cJSON * root;
+
+	root = cJSON_Parse(nested(CJSON_NESTING_LIMIT));
+	CHECK(root != NULL);
+	cJSON_Delete(root);
+	CHECK(cJSON_Parse(nested(CJSON_NESTING_LIMIT + 1)) == NULL);
+
+	//a skipped member counts from the top level object like a parsed one
+	snprintf(json, sizeof(json), "{\"meta\":%s,\"commands\":1}", nested(CJSON_NESTING_LIMIT - 1));
+	root = parse_filtered(json);
+	CHECK(root != NULL);
+	cJSON_Delete(root);
+	snprintf(json, sizeof(json), "{\"meta\":%s,\"commands\":1}", nested(CJSON_NESTING_LIMIT));
+	CHECK(parse_filtered(json) == NULL);
+}
+
+static void test_numbers()
+{
+	const char * spellings[] = { "1", "-1", "+1", ".5", "1.", "1e3", "1E+3", "-0.25e-2", "-", "e1", "1e", "12345678901" };
+	char json[64];
+	cJSON * parsed;
+	cJSON * skipped;
+	size_t i;
+
+	//a skipped number is accepted exactly when parsing it is
+	for(i = 0; i < sizeof(spellings) / sizeof(spellings[0]); i++){
+		snprintf(json, sizeof(json), "{\"n\":%s}", spellings[i]);
+		parsed = cJSON_Parse(json);
+		snprintf(json, sizeof(json), "{\"n\":%s,\"commands\":1}", spellings[i]);
+		skipped = parse_filtered(json);
+		CHECK((parsed != NULL) == (skipped != NULL));
+		cJSON_Delete(parsed);
+		cJSON_Delete(skipped);
+	}
+
+	parsed = cJSON_Parse("[123456789,-42,2147483648,-2147483649,2.75]");
+	CHECK(cJSON_GetArrayItem(parsed, 0)->valueint == 123456789);
+	CHECK(cJSON_GetArrayItem(parsed, 1)->valueint == -42);
+	CHECK(cJSON_GetArrayItem(parsed, 2)->valueint == 2147483647);
+	CHECK(cJSON_GetArrayItem(parsed, 3)->valueint <= -2147483647);
+	CHECK(cJSON_GetArrayItem(parsed, 4)->valueint == 2);
+#ifndef CJSON_INT_ONLY
+	CHECK(cJSON_GetArrayItem(parsed, 4)->valuedouble == 2.75);
+#endif
+	cJSON_Delete(parsed);
+}
+
+int main()
+{
+	test_object_lookup();
+	test_array_access();
+	test_references();
+	test_filtered();
+	test_nesting();
+	test_numbers();
+	TEST_DONE();
+}
@@ -0,0 +1,280 @@
+/*
+ * test_concurrency.c
+ *
+ *  Several handler threads at once on what the socket server handlers share:
+ *  the worker ring behind the submit lock, the job tracker with a worker that
+ *  completes the jobs, the idempotency cache, and request parsing with a
+ *  per-thread arena and the shared node slab.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "hostRTOS.h"
+#include "rfRing.h"
+#include "jobTracker.h"
+#include "idempotencyCache.h"
+#include "requestArena.h"
+#include "cJSON.h"
+#include "test.h"
+
+#define HANDLERS	4
+#define DEPTH		32
+#define BATCHES		20000		//per handler
+#define JOBS		2000		//per handler
+#define ROUNDS		2000
+#define PARSES		5000		//per handler
+
+#define BATCH_BITS	16
+
+#define TTL_TICKS	(IDEMPOTENCYCACHE_TTL_MS / portTICK_PERIOD_MS)
+
+static SemaphoreHandle_t submitLock;
+static rfRing ring;
+static volatile int attached = 0;
+static volatile int stalled = 0;
+static QueueHandle_t jobQueue;
+static volatile uint32_t created = 0;
+static pthread_barrier_t round_barrier;
+static int claims[ROUNDS][HANDLERS];
+static volatile int failures = 0;
+
+static void fail_at(int line)
+{
+	if(__sync_fetch_and_add(&failures, 1) == 0)
+		printf("%s:%d: first failure\n", __FILE__, line);
+}
+
+#define fail()	fail_at(__LINE__)
+
+static void run(void * (*handler)(void *))
+{
+	pthread_t threads[HANDLERS];
+	long i;
+
+	for(i = 0; i < HANDLERS; i++)
+		pthread_create(&threads[i], NULL, handler, (void *)i);
+	for(i = 0; i < HANDLERS; i++)
+		pthread_join(threads[i], NULL);
+}
+
+/*
+ * @brief the address of a command is its handler and batch number, value its index and repetitions the batch size
+ */
+static void * submitter(void * arg)
+{
+	RFcommand command = { .protocol = RF_PROTOCOL_KAKU, .type = RF_TYPE_DIMMER };
+	int batch, size, i;
+	unsigned seed = (long)arg;
+
+	for(batch = 0; batch < BATCHES && !stalled; ){
+		size = 1 + rand_r(&seed) % 8;
+		xSemaphoreTake(submitLock, portMAX_DELAY);
+		if(!rfRing_reserve(&ring, size)){
+			//the 503 case, the client comes back later
+			xSemaphoreGive(submitLock);
+			sched_yield();
+			continue;
+		}
+		for(i = 0; i < size; i++){
+			command.address = (long)arg << BATCH_BITS | batch;
+			command.value = i;
+			command.repetitions = size;
+			rfRing_stage(&ring, &command);
+			//let the others run in the middle of a batch, also on a single core
+			sched_yield();
+		}
+		rfRing_publish(&ring);
+		xSemaphoreGive(submitLock);
+		batch++;
+	}
+	return NULL;
+}
+
+/*
+ * @brief next command of the ring, 0 when none came for a second, commands were lost
+ */
+static int ring_take(RFcommand * command)
+{
+	while(!rfRing_pop(&ring, command)){
+		if(!ulTaskNotifyTake(pdTRUE, 100) && !rfRing_pop(&ring, command)){
+			stalled = 1;
+			fail();
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void * ring_worker(void * arg)
+{
+	int next[HANDLERS] = { 0 };
+	int done = 0;
+	RFcommand command;
+	RFcommand first;
+	int handler, i;
+
+	rfRing_attach(&ring, xTaskGetCurrentTaskHandle());
+	__sync_synchronize();
+	attached = 1;
+	while(done < HANDLERS && ring_take(&first)){
+		//a batch arrives whole, in order, and after the earlier ones of its handler
+		handler = first.address >> BATCH_BITS;
+		if(first.value != 0 || (first.address & ((1 << BATCH_BITS) - 1)) != next[handler]++)
+			fail();
+		for(i = 1; i < first.repetitions && ring_take(&command); i++){
+			if(command.address != first.address || command.value != i)
+				fail();
+		}
+		if(next[handler] == BATCHES)
+			done++;
+	}
+	return NULL;
+}
+
+static void test_submit()
+{
+	pthread_t worker;
+
+	submitLock = xSemaphoreCreateMutex();
+	CHECK(rfRing_init(&ring, DEPTH));
+	pthread_create(&worker, NULL, ring_worker, NULL);
+	while(!attached)
+		sched_yield();
+	run(submitter);
+	pthread_join(worker, NULL);
+	CHECK(!stalled);
+	CHECK(rfRing_count(&ring) == 0);
+	free(ring.items);
+}
+
+static void * job_worker(void * arg)
+{
+	uint16_t id;
+	int i;
+
+	while(xQueueGenericReceive(jobQueue, &id, portMAX_DELAY, pdFALSE) == pdTRUE && id != 0){
+		jobTracker_started(id, 0);
+		for(i = 0; i < 3; i++)
+			jobTracker_sent(id, 2, 1, 0);
+	}
+	return NULL;
+}
+
+static void * job_handler(void * arg)
+{
+	jobTracker_job job;
+	uint32_t before;
+	uint16_t id;
+	int i;
+
+	for(i = 0; i < JOBS; i++){
+		before = created;
+		id = jobTracker_create(3, xTaskGetCurrentTaskHandle(), 0);
+		__sync_fetch_and_add(&created, 1);
+		xQueueGenericSend(jobQueue, &id, portMAX_DELAY, queueSEND_TO_BACK);
+		//the wait mode of the socket server, woken by the worker that sends the last command
+		if(!jobTracker_wait(id, 100, &job)){
+			//a handler that did not run for a while may find its record reused by a job
+			//JOBTRACKER_JOBS newer, the other handlers may not have counted theirs yet
+			if(created - before <= JOBTRACKER_JOBS - HANDLERS)
+				fail();
+		}else if(job.id != id || job.state != JOB_DONE || job.repetitions != 6 || job.airtime != 3){
+			fail();
+		}
+	}
+	return NULL;
+}
+
+static void test_jobs()
+{
+	pthread_t worker;
+	uint16_t stop = 0;
+
+	jobQueue = xQueueCreate(HANDLERS, sizeof(uint16_t));
+	pthread_create(&worker, NULL, job_worker, NULL);
+	run(job_handler);
+	xQueueGenericSend(jobQueue, &stop, portMAX_DELAY, queueSEND_TO_BACK);
+	pthread_join(worker, NULL);
+}
+
+/*
+ * @brief every handler claims the same keys each round, exactly one of them may get each
+ */
+static void * key_handler(void * arg)
+{
+	frameDispatcher_result result = { .queued = 1 };
+	int handler = (long)arg;
+	char key[16];
+	int round, k, parsed;
+
+	for(round = 0; round < ROUNDS; round++){
+		//the keys of the rounds before have expired
+		if(pthread_barrier_wait(&round_barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+			hostRTOS_ticks = round * TTL_TICKS;
+		pthread_barrier_wait(&round_barrier);
+		for(k = 0; k < HANDLERS; k++){
+			snprintf(key, sizeof(key), "r%d-k%d", round, (k + handler) % HANDLERS);
+			if(idempotencyCache_claim(key, round * TTL_TICKS, &result, &parsed) == IDEMPOTENCY_NEW){
+				__sync_fetch_and_add(&claims[round][(k + handler) % HANDLERS], 1);
+				idempotencyCache_store(key, &result, 1);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void test_keys()
+{
+	int round, k;
+
+	pthread_barrier_init(&round_barrier, NULL, HANDLERS);
+	run(key_handler);
+	pthread_barrier_destroy(&round_barrier);
+	for(round = 0; round < ROUNDS; round++){
+		for(k = 0; k < HANDLERS; k++)
+			CHECK(claims[round][k] == 1);
+	}
+	hostRTOS_ticks = 0;
+}
+
+static void * parser(void * arg)
+{
+	char json[160];
+	requestArena arena;
+	cJSON * root;
+	cJSON * command;
+	int i;
+
+	for(i = 0; i < PARSES; i++){
+		snprintf(json, sizeof(json), "{\"commands\":[{\"protocol\":\"kaku\",\"address\":%d,\"unit\":%ld,\"value\":%d},"
+				"{\"protocol\":\"kaku\",\"address\":%d,\"unit\":2,\"value\":1}],\"wait\":true}", i, (long)arg, i % 16, i);
+		requestArena_begin(&arena, strlen(json));
+		root = cJSON_Parse(json);
+		command = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "commands"), 0);
+		if(command == NULL || cJSON_GetObjectItem(command, "address")->valueint != i ||
+				cJSON_GetObjectItem(command, "unit")->valueint != (long)arg ||
+				strcmp(cJSON_GetObjectItem(command, "protocol")->valuestring, "kaku") != 0)
+			fail();
+		cJSON_Delete(root);
+		requestArena_end(&arena);
+	}
+	return NULL;
+}
+
+static void test_parse()
+{
+	requestArena_init();
+	run(parser);
+	cJSON_InitHooks(NULL);
+}
+
+int main()
+{
+	test_submit();
+	test_jobs();
+	test_keys();
+	test_parse();
+	CHECK(failures == 0);
+	TEST_DONE();
+}
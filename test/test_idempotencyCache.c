@@ -0,0 +1,56 @@
+/*
+ * test_idempotencyCache.c
+ *
+ *  Claims of request keys and how long they are remembered.
+ */
+#include <string.h>
+#include "hostRTOS.h"
+#include "idempotencyCache.h"
+#include "test.h"
+
+#define TTL_TICKS	(IDEMPOTENCYCACHE_TTL_MS / portTICK_PERIOD_MS)
+
+int main()
+{
+	frameDispatcher_result result;
+	frameDispatcher_result original;
+	int parsed = 0;
+	char key[16];
+	int i;
+
+	memset(&original, 0, sizeof(original));
+	original.queued = 3;
+	original.job = 42;
+	hostRTOS_ticks = 1000;
+
+	CHECK(idempotencyCache_claim("abc", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_NEW);
+	CHECK(idempotencyCache_claim("abc", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_PENDING);
+	idempotencyCache_store("abc", &original, 3);
+	memset(&result, 0, sizeof(result));
+	CHECK(idempotencyCache_claim("abc", hostRTOS_ticks + 1, &result, &parsed) == IDEMPOTENCY_DUPLICATE);
+	CHECK(parsed == 3 && result.queued == 3 && result.job == 42);
+	CHECK(idempotencyCache_claim("ABC", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_NEW);
+
+	//a released key may be tried again
+	idempotencyCache_release("ABC");
+	CHECK(idempotencyCache_claim("ABC", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_NEW);
+
+	//keys past their time are new again
+	CHECK(idempotencyCache_claim("abc", hostRTOS_ticks + TTL_TICKS - 1, &result, &parsed) == IDEMPOTENCY_DUPLICATE);
+	CHECK(idempotencyCache_claim("abc", hostRTOS_ticks + TTL_TICKS, &result, &parsed) == IDEMPOTENCY_NEW);
+
+	//long keys are cut, what is left still tells them apart by hash
+	CHECK(idempotencyCache_claim("0123456789012345678901234567890123456789-a", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_NEW);
+	CHECK(idempotencyCache_claim("0123456789012345678901234567890123456789-b", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_NEW);
+	CHECK(idempotencyCache_claim("0123456789012345678901234567890123456789-a", hostRTOS_ticks, &result, &parsed) == IDEMPOTENCY_PENDING);
+
+	//a full cache forgets the oldest keys first
+	for(i = 0; i < 4 * IDEMPOTENCYCACHE_ENTRIES; i++){
+		snprintf(key, sizeof(key), "k%d", i);
+		CHECK(idempotencyCache_claim(key, hostRTOS_ticks + 10 + i, &result, &parsed) == IDEMPOTENCY_NEW);
+	}
+	CHECK(idempotencyCache_claim("k0", hostRTOS_ticks + 1000, &result, &parsed) == IDEMPOTENCY_NEW);
+	CHECK(hostRTOS_critical == 0);
+
+	TEST_DONE();
+}
@@ -0,0 +1,117 @@
+/*
+ * test_jsonPull.c
+ *
+ *  A document gives the same tokens fed whole or a byte at a time, broken ones
+ *  stop at the byte where they break.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "jsonPull.h"
+#include "test.h"
+
+/*
+ * @brief tokens of json as one line of text, chunk bytes are fed at a time, returns the last token
+ */
+static int tokens(const char * json, size_t chunk, char * out, size_t size, jsonPull * state)
+{
+	size_t length = strlen(json);
+	size_t fed = 0;
+	size_t used = 0;
+	int token;
+
+	out[0] = 0;
+	jsonPull_init(state);
+	for(;;){
+		token = jsonPull_next(state);
+		if(token == JSONPULL_MORE){
+			size_t n = length - fed < chunk ? length - fed : chunk;
+			if(n == 0)
+				return token;
+			jsonPull_feed(state, json + fed, n);
+			fed += n;
+			continue;
+		}
+		if(token == JSONPULL_END || token == JSONPULL_ERROR)
+			return token;
+		if(token == JSONPULL_KEY || token == JSONPULL_STRING)
+			used += snprintf(out + used, size - used, "%d'%s' ", token, state->text);
+		else if(token == JSONPULL_NUMBER)
+			used += snprintf(out + used, size - used, "%d'%s'=%d ", token, state->text, (int)state->integer);
+		else
+			used += snprintf(out + used, size - used, "%d ", token);
+	}
+}
+
+static void test_chunks()
+{
+	const char * json = " {\"commands\" : [ {\"address\":12345, \"value\":-7.5e+2, \"on\":true},"
+			"{\"x\":[false,null,[]],\"s\":\"a\\\"b\\\\c\\u00e9\\n\"}], \"big\":99999999999, \"e\":{}}  ";
+	char whole[1024];
+	char bytes[1024];
+	jsonPull state;
+
+	CHECK(tokens(json, strlen(json), whole, sizeof(whole), &state) == JSONPULL_END);
+	CHECK(tokens(json, 1, bytes, sizeof(bytes), &state) == JSONPULL_END);
+	CHECK(strcmp(whole, bytes) == 0);
+	CHECK(strstr(whole, "7'12345'=12345 ") != NULL);
+	CHECK(strstr(whole, "7'-7.5e+2'=-7 ") != NULL);
+	CHECK(strstr(whole, "7'99999999999'=2147483647 ") != NULL);
+	CHECK(strstr(whole, "6'a\"b\\c\xc3\xa9\n' ") != NULL);
+}
+
+static void test_errors()
+{
+	const char * broken[] = { "[01]", "[tru]", "[1,]", "{\"a\" 1}", "{1:2}", "[\"\\x\"]", "[\"\\u12g4\"]", "]", "[-]", "[1.]", "[1e]" };
+	char out[256];
+	jsonPull state;
+	size_t i;
+
+	for(i = 0; i < sizeof(broken) / sizeof(broken[0]); i++){
+		CHECK(tokens(broken[i], 1, out, sizeof(out), &state) == JSONPULL_ERROR);
+		//errors are sticky
+		CHECK(jsonPull_next(&state) == JSONPULL_ERROR);
+	}
+
+	tokens("{\"a\":[1,2,}", 64, out, sizeof(out), &state);
+	CHECK(state.offset == 10);
+
+	//a document that is not finished asks for more
+	CHECK(tokens("{\"a\":[1,2", 64, out, sizeof(out), &state) == JSONPULL_MORE);
+	//what follows the document is left alone
+	CHECK(tokens("[1] trailing", 64, out, sizeof(out), &state) == JSONPULL_END);
+	CHECK(state.offset == 3);
+}
+
+static void test_limits()
+{
+	char json[2 * JSONPULL_MAX_DEPTH + 8];
+	char out[1024];
+	char text[JSONPULL_TEXT_SIZE * 2 + 8];
+	jsonPull state;
+	int depth;
+
+	for(depth = JSONPULL_MAX_DEPTH; depth <= JSONPULL_MAX_DEPTH + 1; depth++){
+		memset(json, '[', depth);
+		memset(json + depth, ']', depth);
+		json[2 * depth] = 0;
+		CHECK(tokens(json, 64, out, sizeof(out), &state) == (depth == JSONPULL_MAX_DEPTH ? JSONPULL_END : JSONPULL_ERROR));
+	}
+
+	//long strings are cut to the text buffer and flagged
+	text[0] = '"';
+	memset(text + 1, 'x', JSONPULL_TEXT_SIZE * 2);
+	strcpy(text + 1 + JSONPULL_TEXT_SIZE * 2, "\"");
+	jsonPull_init(&state);
+	jsonPull_feed(&state, text, strlen(text));
+	CHECK(jsonPull_next(&state) == JSONPULL_STRING);
+	CHECK(state.truncated);
+	CHECK(strlen(state.text) == JSONPULL_TEXT_SIZE - 1);
+}
+
+int main()
+{
+	test_chunks();
+	test_errors();
+	test_limits();
+	TEST_DONE();
+}
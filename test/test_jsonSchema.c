@@ -0,0 +1,79 @@
+/*
+ * test_jsonSchema.c
+ *
+ *  Extraction against the command fields the dispatcher uses.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "jsonSchema.h"
+#include "test.h"
+
+typedef struct {
+		const char * protocol;
+		int value;
+		int unit;
+		int repeat;
+		int group;
+		cJSON_number level;
+		const cJSON * fade;
+}commandFields;
+
+static const jsonSchemaField fields[] = {
+	{ "protocol",	JSONSCHEMA_STRING,	1, offsetof(commandFields, protocol),	0 },
+	{ "value",		JSONSCHEMA_INT,		1, offsetof(commandFields, value),		0 },
+	{ "unit",		JSONSCHEMA_INT,		1, offsetof(commandFields, unit),		0 },
+	{ "repeat",		JSONSCHEMA_INT,		0, offsetof(commandFields, repeat),		25 },
+	{ "group",		JSONSCHEMA_BOOL,	0, offsetof(commandFields, group),		0 },
+	{ "level",		JSONSCHEMA_NUMBER,	0, offsetof(commandFields, level),		3 },
+	{ "fade",		JSONSCHEMA_ANY,		0, offsetof(commandFields, fade),		0 }
+};
+
+/*
+ * @brief out points into the tree, it is kept until the next call
+ */
+static int extract(const jsonSchema * schema, const char * json, commandFields * out, const char ** key)
+{
+	static cJSON * object = NULL;
+
+	cJSON_Delete(object);
+	object = cJSON_Parse(json);
+	*key = NULL;
+	return jsonSchema_extract(schema, object, out, key);
+}
+
+int main()
+{
+	jsonSchema schema;
+	commandFields out;
+	const char * key;
+	int i;
+
+	CHECK(!jsonSchema_compile(&schema, fields, 0));
+	CHECK(!jsonSchema_compile(&schema, fields, JSONSCHEMA_FIELDS + 1));
+	CHECK(jsonSchema_compile(&schema, fields, sizeof(fields) / sizeof(fields[0])));
+	CHECK(schema.mask + 1u >= 2 * sizeof(fields) / sizeof(fields[0]));
+	for(i = 0; i <= schema.mask; i++)
+		CHECK(schema.slots[i] <= sizeof(fields) / sizeof(fields[0]));
+
+	//case-insensitive, the first of duplicates counts, unknown members are ignored
+	CHECK(extract(&schema, "{\"Protocol\":\"kaku\",\"VALUE\":3,\"value\":4,\"unit\":2,\"other\":1,\"fade\":{}}", &out, &key) == JSONSCHEMA_OK);
+	CHECK(key == NULL);
+	CHECK(out.value == 3 && out.unit == 2);
+	CHECK(out.repeat == 25 && out.group == 0 && out.level == 3);
+	CHECK(cJSON_IsObject(out.fade));
+
+	CHECK(extract(&schema, "{\"protocol\":\"kaku\",\"value\":3,\"group\":true,\"level\":1}", &out, &key) == JSONSCHEMA_MISSING);
+	CHECK(strcmp(key, "unit") == 0);
+	CHECK(out.group == 1 && out.level == 1);
+
+	CHECK(extract(&schema, "{\"protocol\":\"kaku\",\"value\":\"3\",\"unit\":1}", &out, &key) == JSONSCHEMA_TYPE);
+	CHECK(strcmp(key, "value") == 0);
+	CHECK(extract(&schema, "{\"protocol\":\"kaku\",\"value\":3,\"unit\":1,\"group\":1}", &out, &key) == JSONSCHEMA_TYPE);
+	CHECK(strcmp(key, "group") == 0);
+
+	//not an object, everything is absent
+	CHECK(extract(&schema, "5", &out, &key) == JSONSCHEMA_MISSING);
+	CHECK(out.protocol == NULL && out.fade == NULL && out.repeat == 25);
+
+	TEST_DONE();
+}
@@ -0,0 +1,55 @@
+/*
+ * test_nodeSlab.c
+ *
+ *  Slots are handed out until the slab is full, later nodes come from the heap
+ *  and every free goes back where its node came from. cJSON trees built on the
+ *  slab return all of their nodes.
+ */
+#include <stdlib.h>
+#include "cJSON.h"
+#include "nodeSlab.h"
+#include "test.h"
+
+#define SLOTS	4
+
+int main()
+{
+	cJSON_Hooks hooks = { nodeSlab_alloc, nodeSlab_free };
+	nodeSlab_stats stats;
+	void * nodes[SLOTS + 2];
+	cJSON * root;
+	int i;
+
+	CHECK(nodeSlab_init(sizeof(cJSON), SLOTS));
+	for(i = 0; i < SLOTS + 2; i++)
+		CHECK((nodes[i] = nodeSlab_alloc(sizeof(cJSON))) != NULL);
+	//bigger than a slot goes to the heap even while slots are free
+	nodeSlab_free(nodes[0]);
+	nodes[0] = nodeSlab_alloc(sizeof(cJSON) * 2);
+
+	nodeSlab_get_stats(&stats);
+	CHECK(stats.capacity == SLOTS);
+	CHECK(stats.in_use == SLOTS - 1);
+	CHECK(stats.peak == SLOTS);
+	CHECK(stats.allocations == SLOTS + 3);
+	CHECK(stats.fallbacks == 3);
+
+	for(i = 0; i < SLOTS + 2; i++)
+		nodeSlab_free(nodes[i]);
+	nodeSlab_get_stats(&stats);
+	CHECK(stats.in_use == 0);
+
+	//a tree bigger than the slab spills over and still comes back whole
+	cJSON_InitNodeHooks(&hooks);
+	root = cJSON_Parse("{\"commands\":[{\"address\":1,\"unit\":2},{\"address\":3,\"unit\":4}]}");
+	CHECK(root != NULL);
+	nodeSlab_get_stats(&stats);
+	CHECK(stats.in_use == SLOTS);
+	cJSON_Delete(root);
+	nodeSlab_get_stats(&stats);
+	CHECK(stats.in_use == 0);
+	CHECK(stats.peak == SLOTS);
+	cJSON_InitNodeHooks(NULL);
+
+	TEST_DONE();
+}
@@ -0,0 +1,96 @@
+/*
+ * test_rfRing.c
+ *
+ *  Order, capacity and wakeups of the command ring, also across the wrap of the
+ *  free running indices.
+ */
+#include <stdlib.h>
+#include "hostRTOS.h"
+#include "rfRing.h"
+#include "test.h"
+
+static RFcommand command(int address)
+{
+	RFcommand c = { .address = address, .unit = 1, .protocol = RF_PROTOCOL_KAKU, .type = RF_TYPE_SWITCH, .value = 1 };
+	return c;
+}
+
+static void test_order(rfRing * ring)
+{
+	RFcommand c;
+	int i;
+
+	hostRTOS_notifications = 0;
+	CHECK(rfRing_pop(ring, &c) == 0);
+
+	//a burst is invisible until it is published and wakes the consumer once
+	CHECK(rfRing_reserve(ring, 5));
+	for(i = 0; i < 5; i++)
+		rfRing_stage(ring, &(RFcommand){ .address = 100 + i });
+	CHECK(rfRing_count(ring) == 0);
+	CHECK(rfRing_pop(ring, &c) == 0);
+	rfRing_publish(ring);
+	CHECK(rfRing_count(ring) == 5);
+	CHECK(hostRTOS_notifications == 1);
+
+	//the consumer is still busy, no second wakeup
+	c = command(200);
+	CHECK(rfRing_push(ring, &c));
+	CHECK(hostRTOS_notifications == 1);
+
+	for(i = 0; i < 5; i++){
+		CHECK(rfRing_pop(ring, &c));
+		CHECK(c.address == 100 + i);
+	}
+	CHECK(rfRing_pop(ring, &c) && c.address == 200);
+	CHECK(rfRing_count(ring) == 0);
+
+	//drained, the next command wakes it again
+	c = command(300);
+	CHECK(rfRing_push(ring, &c));
+	CHECK(hostRTOS_notifications == 2);
+	CHECK(rfRing_pop(ring, &c) && c.address == 300);
+}
+
+static void test_full(rfRing * ring)
+{
+	RFcommand c = command(1);
+	uint32_t size = ring->mask + 1;
+	uint32_t i;
+
+	CHECK(!rfRing_reserve(ring, size + 1));
+	CHECK(rfRing_reserve(ring, size));
+	for(i = 0; i < size; i++)
+		CHECK(rfRing_push(ring, &c));
+	CHECK(!rfRing_push(ring, &c));
+	CHECK(!rfRing_reserve(ring, 1));
+	CHECK(rfRing_count(ring) == size);
+	CHECK(rfRing_pop(ring, &c));
+	CHECK(rfRing_reserve(ring, 1));
+	while(rfRing_pop(ring, &c));
+}
+
+int main()
+{
+	rfRing ring;
+
+	CHECK(rfRing_init(&ring, 5));
+	CHECK(ring.mask == 7);
+	free(ring.items);
+	CHECK(rfRing_init(&ring, 8));
+	CHECK(ring.mask == 7);
+	rfRing_attach(&ring, xTaskGetCurrentTaskHandle());
+
+	test_order(&ring);
+	test_full(&ring);
+
+	//the same just before and across the wrap of head and tail
+	ring.head = ring.tail = UINT32_MAX - 2;
+	test_order(&ring);
+	ring.head = ring.tail = UINT32_MAX - 2;
+	test_full(&ring);
+	CHECK(ring.head < 16);
+
+	free(ring.items);
+	TEST_DONE();
+}
@@ -0,0 +1,161 @@
+/*
+ * test_scheduler.c
+ *
+ *  The timer wheel against a fake command queue and fade engine. The wheel
+ *  timer only moves when the test fires it, one fire is one wheel tick.
+ */
+#include <string.h>
+#include "hostRTOS.h"
+#include "scheduler.h"
+#include "test.h"
+
+#define QUEUE_SIZE	64
+
+static RFcommand queued[QUEUE_SIZE];
+static int queue_count = 0;
+static int queue_full = 0;
+static int fades_held = 0;
+static int fades_prepared = 0;
+
+int frameDispatcher_enqueue(const RFcommand * command, TickType_t wait)
+{
+	if(queue_full || queue_count == QUEUE_SIZE)
+		return 0;
+	queued[queue_count++] = *command;
+	return 1;
+}
+
+int fadeEngine_prepare(const RFcommand * command, const fadeRequest * request)
+{
+	fades_prepared++;
+	fades_held++;
+	return 1 + request->curve;
+}
+
+void fadeEngine_release(int fade)
+{
+	if(fade)
+		fades_held--;
+}
+
+static void ticks(int count)
+{
+	while(count-- > 0){
+		CHECK(hostRTOS_timer_armed());
+		hostRTOS_timer_fire();
+		CHECK(hostRTOS_critical == 0);
+	}
+}
+
+static RFcommand command(int address)
+{
+	RFcommand c = { .address = address, .unit = 1, .protocol = RF_PROTOCOL_KAKU, .type = RF_TYPE_DIMMER, .value = 10 };
+	return c;
+}
+
+static void test_one_shot()
+{
+	RFcommand c = command(1);
+
+	queue_count = 0;
+	CHECK(scheduler_add(&c, 250, 0, NULL) >= 0);
+	CHECK(hostRTOS_timer_armed());
+	ticks(2);
+	CHECK(queue_count == 0);
+	ticks(1);
+	CHECK(queue_count == 1 && queued[0].address == 1);
+	//nothing left to wait for, the timer is not started again
+	CHECK(!hostRTOS_timer_armed());
+}
+
+static void test_interval_and_cancel()
+{
+	RFcommand c = command(2);
+	int id;
+
+	queue_count = 0;
+	id = scheduler_add(&c, 0, 200, NULL);
+	ticks(6);
+	CHECK(queue_count == 3);
+	CHECK(scheduler_cancel(id) == 1);
+	CHECK(scheduler_cancel(id) == 0);
+	ticks(1);
+	CHECK(!hostRTOS_timer_armed());
+	CHECK(queue_count == 3);
+
+	//the entry is reused, the old id does not cancel the new one
+	c = command(3);
+	CHECK(scheduler_add(&c, 100, 0, NULL) != id);
+	CHECK(scheduler_cancel(id) == 0);
+	ticks(1);
+	CHECK(queue_count == 4 && queued[3].address == 3);
+	CHECK(scheduler_cancel(-1) == 0);
+	CHECK(scheduler_cancel(SCHEDULER_MAX_ENTRIES) == 0);
+}
+
+static void test_full_queue()
+{
+	RFcommand c = command(4);
+	fadeRequest fade = { .from = 0, .duration_ms = 1000, .curve = FADE_EASE };
+
+	queue_count = 0;
+	fades_prepared = fades_held = 0;
+	c.fade = 1;
+	scheduler_add(&c, 100, 0, &fade);
+
+	//every failed run gives its fade slot back and is retried on the next tick
+	queue_full = 1;
+	ticks(3);
+	CHECK(fades_prepared == 3);
+	CHECK(fades_held == 0);
+	queue_full = 0;
+	ticks(1);
+	CHECK(queue_count == 1);
+	CHECK(queued[0].fade == 1 + FADE_EASE);
+	CHECK(fades_held == 1);
+	CHECK(!hostRTOS_timer_armed());
+}
+
+static void test_long_delay()
+{
+	RFcommand c = command(5);
+	int laps = SCHEDULER_WHEEL_SLOTS + 10;
+
+	//an entry further out than one turn of the wheel skips its slot on the first pass
+	queue_count = 0;
+	scheduler_add(&c, laps * SCHEDULER_TICK_MS, 0, NULL);
+	ticks(laps - 1);
+	CHECK(queue_count == 0);
+	ticks(1);
+	CHECK(queue_count == 1);
+}
+
+static void test_capacity()
+{
+	RFcommand c = command(6);
+	int ids[SCHEDULER_MAX_ENTRIES];
+	int i;
+
+	for(i = 0; i < SCHEDULER_MAX_ENTRIES; i++)
+		CHECK((ids[i] = scheduler_add(&c, 1000, 0, NULL)) >= 0);
+	CHECK(scheduler_add(&c, 1000, 0, NULL) == -1);
+	for(i = 0; i < SCHEDULER_MAX_ENTRIES; i++)
+		CHECK(scheduler_cancel(ids[i]) == 1);
+	ticks(1);
+	CHECK(!hostRTOS_timer_armed());
+}
+
+int main()
+{
+	RFcommand c = command(0);
+
+	CHECK(scheduler_add(&c, 100, 0, NULL) == -1);
+	scheduler_init();
+
+	test_one_shot();
+	test_interval_and_cancel();
+	test_full_queue();
+	test_long_delay();
+	test_capacity();
+	TEST_DONE();
+}